@@ -4,6 +4,8 @@
 #include <cp3_llbb/Framework/interface/Category.h>
 #include <cp3_llbb/HHAnalysis/interface/HHAnalyzer.h>
 
+#include <limits>
+
 class DileptonCategory: public Category {
     public:
         const std::vector<HH::Lepton>& getLeptons(const AnalyzersManager& analyzers) const ;
@@ -11,13 +13,41 @@ class DileptonCategory: public Category {
         const std::vector<HH::DileptonMetDijet>& getDileptonMetDijets(const AnalyzersManager& analyzers) const ;
         virtual void configure(const edm::ParameterSet& conf) override {
             m_analyzer_name = conf.getUntrackedParameter<std::string>("m_analyzer_name", "hh_analyzer");
+            // Lepton selection of the analyzer, used for the pre-analyzer gates
+            m_muons_producer = conf.getUntrackedParameter<std::string>("m_muons_producer", "muons");
+            m_electrons_producer = conf.getUntrackedParameter<std::string>("m_electrons_producer", "electrons");
+            m_muonEtaCut = conf.getUntrackedParameter<double>("m_muonEtaCut", 2.4);
+            m_muonTightIsoCut = conf.getUntrackedParameter<double>("m_muonTightIsoCut", std::numeric_limits<float>::max());
+            m_electronEtaCut = conf.getUntrackedParameter<double>("m_electronEtaCut", 2.5);
+            m_electron_medium_wp_name = conf.getUntrackedParameter<std::string>("m_electron_medium_wp_name", "");
+            m_leadingMuonPtCut = conf.getUntrackedParameter<double>("m_leadingMuonPtCut", 0);
+            m_subleadingMuonPtCut = conf.getUntrackedParameter<double>("m_subleadingMuonPtCut", 0);
+            m_leadingElectronPtCut = conf.getUntrackedParameter<double>("m_leadingElectronPtCut", 0);
+            m_subleadingElectronPtCut = conf.getUntrackedParameter<double>("m_subleadingElectronPtCut", 0);
         }
     private:
         std::string m_analyzer_name;
+        std::string m_muons_producer;
+        std::string m_electrons_producer;
+        float m_muonEtaCut;
+        float m_muonTightIsoCut;
+        float m_electronEtaCut;
+        std::string m_electron_medium_wp_name;
 
     protected:
+        // Number of muons / electrons passing the analyzer eta, ID and isolation cuts, with pt above ptCut
+        size_t countMuons(const ProducersManager& producers, float ptCut) const;
+        size_t countElectrons(const ProducersManager& producers, float ptCut) const;
+
         float m_leadingLeptonPtCut;
         float m_subleadingLeptonPtCut;
+
+        // Lepton pt cuts of the analyzer. The pre-analyzer gates use the loosest of these and of the category cuts, so that
+        // they never reject an event the analyzer would count
+        float m_leadingMuonPtCut;
+        float m_subleadingMuonPtCut;
+        float m_leadingElectronPtCut;
+        float m_subleadingElectronPtCut;
 };
 
 class MuMuCategory: public DileptonCategory {
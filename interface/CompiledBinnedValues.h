@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cp3_llbb/Framework/interface/BinnedValues.h>
+
+#include <cp3_llbb/HHAnalysis/interface/Types.h>
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace HH {
+
+    // One axis of a compiled table, with its edges stored contiguously
+    struct CompiledAxis {
+        BinningVariable variable; // Eta, AbsEta or Pt
+        const float* edges; // n_bins + 1 edges
+        uint32_t n_bins;
+
+        // Bin of 'value'. Outside of the binning, the closest bin, with out_of_range set
+        size_t find(float value, bool& out_of_range) const {
+            if (!(value >= edges[0])) {
+                out_of_range = true;
+                return 0;
+            }
+            if (value >= edges[n_bins]) {
+                out_of_range = true;
+                return n_bins - 1;
+            }
+
+            // Count of the edges below the value, without branches: the tables have a few tens of edges at most,
+            // which fit in one or two cache lines
+            size_t bin = 0;
+            for (uint32_t i = 1; i < n_bins; i++)
+                bin += (value >= edges[i]);
+            return bin;
+        }
+    };
+
+    // Two-dimensional binned efficiency generated at build time from its JSON file (see scripts/generateEfficiencyTables.py),
+    // giving the same values as BinnedValues. Outside of the binning, the closest bin is used with doubled errors.
+    struct CompiledBinnedValues {
+        CompiledAxis x;
+        CompiledAxis y;
+        // Row-major: bin (i, j) is values[i * y.n_bins + j]
+        const EfficiencyValue* values;
+        // Values used outside of the binning, in the same order. nullptr: the values with doubled errors
+        const EfficiencyValue* out_of_range_values;
+
+        EfficiencyValue get(float eta, float pt) const {
+            return at(value(x.variable, eta, pt), value(y.variable, eta, pt));
+        }
+
+        // Value at the given coordinates along x and y
+        EfficiencyValue at(float x_value, float y_value) const {
+            bool out_of_range = false;
+            size_t i = x.find(x_value, out_of_range);
+            size_t j = y.find(y_value, out_of_range);
+
+            if (out_of_range && out_of_range_values)
+                return out_of_range_values[i * y.n_bins + j];
+
+            EfficiencyValue result = values[i * y.n_bins + j];
+            if (out_of_range) {
+                result.error_low *= 2;
+                result.error_high *= 2;
+            }
+            return result;
+        }
+
+        private:
+            static float value(BinningVariable variable, float eta, float pt) {
+                switch (variable) {
+                    case BinningVariable::Eta: return eta;
+                    case BinningVariable::AbsEta: return std::abs(eta);
+                    default: return pt;
+                }
+            }
+    };
+
+    // Weighted average of compiled tables (e.g. the run periods of a WeightedBinnedValues, weighted by their luminosity),
+    // merged once into a single table on the union of their bin edges. The errors of the parts are added in quadrature.
+    // As with WeightedBinnedValues, the errors of a part are doubled where it is out of its own binning, once: inside the
+    // union, for the parts narrower than the union, and outside of it, for all the parts.
+    class MergedBinnedValues {
+        public:
+            // Throws std::invalid_argument if the parts are not binned in the same variables
+            explicit MergedBinnedValues(const std::vector<std::pair<const CompiledBinnedValues*, double>>& parts);
+            MergedBinnedValues(const MergedBinnedValues&) = delete;
+            MergedBinnedValues& operator=(const MergedBinnedValues&) = delete;
+
+            const CompiledBinnedValues& table() const { return m_table; }
+
+        private:
+            std::vector<float> m_x_edges;
+            std::vector<float> m_y_edges;
+            std::vector<EfficiencyValue> m_values;
+            std::vector<EfficiencyValue> m_out_of_range_values;
+            CompiledBinnedValues m_table;
+    };
+
+    // 64-bit FNV-1a hash of the content of a file
+    uint64_t contentHash(const std::string& path);
+
+    // Compiled table of a JSON file, from its path relative to the src directory and its full path (edm::FileInPath::relativePath()
+    // and fullPath()), nullptr if none. Throws std::runtime_error if the file changed since the table was generated.
+    const CompiledBinnedValues* findCompiledBinnedValues(const std::string& relative_path, const std::string& full_path);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cp3_llbb/HHAnalysis/interface/Types.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace HH {
+
+    // Selection expression compiled once into a flat stack program, with the syntax of the cut strings of the
+    // framework producers (StringCutObjectSelector), e.g. "pt > 20 && abs(eta) < 2.4":
+    //  - numbers, true and false, and the variables given at compilation (an optional "()" after a name is ignored)
+    //  - unary -, ! (or 'not'), functions abs(x) and sqrt(x)
+    //  - * / + -, comparisons < <= > >= == !=, && (or 'and') and || (or 'or'), with the usual precedences
+    // Booleans are 0 or 1. Sub-expressions without variables are folded at compilation, and the right operand of
+    // a binary operation is an immediate when it is a constant, so that "pt > 20" is two instructions.
+    class CutProgram {
+        public:
+            // Empty program: accepts everything
+            CutProgram() = default;
+            // Throws std::invalid_argument on syntax errors and unknown variables
+            CutProgram(const std::string& expression, const std::vector<std::string>& variables);
+
+            bool empty() const { return m_code.empty(); }
+            // Indices in the list given at compilation of the variables used, in the order expected by evaluate()
+            const std::vector<uint16_t>& variables() const { return m_variables; }
+
+            float evaluate(const float* variables) const;
+
+            enum class Op: uint8_t {
+                Constant, Variable,
+                Negate, Not, Abs, Sqrt,
+                Add, Subtract, Multiply, Divide,
+                Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual,
+                And, Or
+            };
+
+            struct Instruction {
+                Op op;
+                // Binary operations: the right operand is 'value' instead of the top of the stack
+                bool immediate;
+                // Variable: index in the values given to evaluate()
+                uint16_t index;
+                float value;
+            };
+
+            static constexpr size_t max_stack_size = 32;
+
+        private:
+            friend class CutParser;
+
+            std::vector<Instruction> m_code;
+            std::vector<uint16_t> m_variables;
+    };
+
+    // Variables available to the cut strings on objects of type T
+    template <typename T>
+    using CutVariables = std::vector<std::pair<std::string, float (*)(const T&)>>;
+
+    // Cut on objects of type T
+    template <typename T>
+    class CutExpression {
+        public:
+            CutExpression() = default;
+            CutExpression(const std::string& expression, const CutVariables<T>& variables) {
+                std::vector<std::string> names;
+                for (const auto& variable: variables)
+                    names.push_back(variable.first);
+                m_program = CutProgram(expression, names);
+                for (uint16_t index: m_program.variables())
+                    m_accessors.push_back(variables[index].second);
+            }
+
+            bool empty() const { return m_program.empty(); }
+
+            bool operator()(const T& object) const {
+                if (m_program.empty())
+                    return true;
+
+                float values[CutProgram::max_stack_size];
+                for (size_t i = 0; i < m_accessors.size(); i++)
+                    values[i] = m_accessors[i](object);
+                return m_program.evaluate(values) != 0;
+            }
+
+        private:
+            CutProgram m_program;
+            std::vector<float (*)(const T&)> m_accessors;
+    };
+
+    const CutVariables<Lepton>& leptonCutVariables();
+    const CutVariables<Jet>& jetCutVariables();
+    const CutVariables<DileptonMetDijet>& dileptonMetDijetCutVariables();
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cp3_llbb/HHAnalysis/interface/Types.h>
+#include <cp3_llbb/HHAnalysis/interface/Indices.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace HH {
+
+    // Lepton flavours, as seen by the trigger
+    namespace flavour {
+        struct Mu {
+            // PDG ID of the HLT objects
+            static bool isHLTObject(int pdg_id) { return std::abs(pdg_id) == 13; }
+            // Legs of the same-flavour and different-flavour dilepton triggers
+            static constexpr HHAnalysis::triggerLeg::triggerLeg sameFlavourLeg1() { return HHAnalysis::triggerLeg::IsoMu17; }
+            static constexpr HHAnalysis::triggerLeg::triggerLeg sameFlavourLeg2() { return HHAnalysis::triggerLeg::IsoMu8orIsoTkMu8; }
+            static constexpr HHAnalysis::triggerLeg::triggerLeg differentFlavourLeg1() { return HHAnalysis::triggerLeg::IsoMu23; }
+            static constexpr HHAnalysis::triggerLeg::triggerLeg differentFlavourLeg2() { return HHAnalysis::triggerLeg::IsoMu8; }
+        };
+
+        struct El {
+            // It is unfortunate but the PDG ID is not correct in HLT objects
+            static bool isHLTObject(int pdg_id) { return pdg_id == 0; }
+            static constexpr HHAnalysis::triggerLeg::triggerLeg sameFlavourLeg1() { return HHAnalysis::triggerLeg::DoubleEleHighPt; }
+            static constexpr HHAnalysis::triggerLeg::triggerLeg sameFlavourLeg2() { return HHAnalysis::triggerLeg::DoubleEleLowPt; }
+            static constexpr HHAnalysis::triggerLeg::triggerLeg differentFlavourLeg1() { return HHAnalysis::triggerLeg::EleMuHighPt; }
+            static constexpr HHAnalysis::triggerLeg::triggerLeg differentFlavourLeg2() { return HHAnalysis::triggerLeg::MuEleLowPt; }
+        };
+    }
+
+    // Trigger choices of a same-flavour channel: the leg efficiencies of the double lepton path, and the filters telling
+    // which lepton fired which leg. The legs can have asymmetric cuts.
+    struct SameFlavourDileptonChannel {
+        // Leg efficiencies of a lepton of flavour Flavour, cached in the lepton (bit 'cached' of hlt_efficiencies_cached)
+        template <typename Flavour> static constexpr HHAnalysis::triggerLeg::triggerLeg leg1Of() { return Flavour::sameFlavourLeg1(); }
+        template <typename Flavour> static constexpr HHAnalysis::triggerLeg::triggerLeg leg2Of() { return Flavour::sameFlavourLeg2(); }
+        static EfficiencyValue& leg1Efficiency(Lepton& lepton) { return lepton.hlt_eff_SF_leg1; }
+        static EfficiencyValue& leg2Efficiency(Lepton& lepton) { return lepton.hlt_eff_SF_leg2; }
+        static constexpr uint8_t cached = 1;
+    };
+
+    // Trigger choices of a different-flavour channel: leg 1 is always the muon, and leg 2 the electron
+    struct DifferentFlavourDileptonChannel {
+        template <typename Flavour> static constexpr HHAnalysis::triggerLeg::triggerLeg leg1Of() { return Flavour::differentFlavourLeg1(); }
+        template <typename Flavour> static constexpr HHAnalysis::triggerLeg::triggerLeg leg2Of() { return Flavour::differentFlavourLeg2(); }
+        static EfficiencyValue& leg1Efficiency(Lepton& lepton) { return lepton.hlt_eff_DF_leg1; }
+        static EfficiencyValue& leg2Efficiency(Lepton& lepton) { return lepton.hlt_eff_DF_leg2; }
+        static constexpr uint8_t cached = 2;
+    };
+
+    // Trigger choices of the dilepton channel with leptons of flavours Flavour1 and Flavour2, fixed at compilation
+    template <typename Flavour1, typename Flavour2>
+    struct DileptonChannel;
+
+    template <>
+    struct DileptonChannel<flavour::Mu, flavour::Mu>: public SameFlavourDileptonChannel {
+        using Flavour1 = flavour::Mu;
+        using Flavour2 = flavour::Mu;
+        static const char* name() { return "di-muon"; }
+
+        // See https://cp3-llbb.slack.com/archives/hh/p1486479524001043
+        static constexpr float dzFilterEfficiency() { return 0.993; }
+        // FIXME L1 EMTF bug, see https://cp3-llbb.slack.com/archives/hh/p1486566100001301
+        static constexpr bool hasL1EMTFBug = true;
+        static constexpr float l1EMTFBugEfficiency() { return 0.5265; }
+
+        static constexpr HHAnalysis::triggerLeg::triggerLeg leg1 = HHAnalysis::triggerLeg::IsoMu17;
+        static constexpr HHAnalysis::triggerLeg::triggerLeg leg2 = HHAnalysis::triggerLeg::IsoMu8orIsoTkMu8;
+        // Taken from https://github.com/cms-analysis/MuonAnalysis-TagAndProbe/blob/fa1f8f3d469a5a78754ed4b4c43adbfad39a2544/python/common_variables_cff.py#L253-L264
+        static const std::vector<std::string>& leg1Filters() {
+            static const std::vector<std::string> filters = {
+                "hltL3fL1sDoubleMu114L1f0L2f10OneMuL3Filtered17",
+                "hltL3fL1sDoubleMu114L1f0L2f10L3Filtered17"
+            };
+            return filters;
+        }
+        static const std::vector<std::string>& leg2Filters() {
+            static const std::vector<std::string> filters = {
+                "hltL3pfL1sDoubleMu114L1f0L2pf0L3PreFiltered8",
+                "hltDiMuonGlbFiltered17TrkFiltered8",
+                "hltL2pfL1sDoubleMu114ORDoubleMu125L1f0L2PreFiltered0"
+            };
+            return filters;
+        }
+    };
+
+    template <>
+    struct DileptonChannel<flavour::El, flavour::El>: public SameFlavourDileptonChannel {
+        using Flavour1 = flavour::El;
+        using Flavour2 = flavour::El;
+        static const char* name() { return "di-electron"; }
+
+        // See https://cp3-llbb.slack.com/archives/hh/p1486482180001053
+        static constexpr float dzFilterEfficiency() { return 0.983; }
+        static constexpr bool hasL1EMTFBug = false;
+        static constexpr float l1EMTFBugEfficiency() { return 1; }
+
+        static constexpr HHAnalysis::triggerLeg::triggerLeg leg1 = HHAnalysis::triggerLeg::DoubleEleHighPt;
+        static constexpr HHAnalysis::triggerLeg::triggerLeg leg2 = HHAnalysis::triggerLeg::DoubleEleLowPt;
+        static const std::vector<std::string>& leg1Filters() {
+            static const std::vector<std::string> filters = {
+                "hltEle17Ele12CaloIdLTrackIdLIsoVLTrackIsoLeg1Filter",
+                "hltEle23Ele12CaloIdLTrackIdLIsoVLTrackIsoLeg1Filter"
+            };
+            return filters;
+        }
+        static const std::vector<std::string>& leg2Filters() {
+            static const std::vector<std::string> filters = {
+                "hltEle17Ele12CaloIdLTrackIdLIsoVLTrackIsoLeg2Filter",
+                "hltEle23Ele12CaloIdLTrackIdLIsoVLTrackIsoLeg2Filter"
+            };
+            return filters;
+        }
+    };
+
+    template <>
+    struct DileptonChannel<flavour::Mu, flavour::El>: public DifferentFlavourDileptonChannel {
+        using Flavour1 = flavour::Mu;
+        using Flavour2 = flavour::El;
+        static const char* name() { return "muon-electron"; }
+
+        static constexpr float dzFilterEfficiency() { return 0.988; }
+        static constexpr bool hasL1EMTFBug = false;
+        static constexpr float l1EMTFBugEfficiency() { return 1; }
+    };
+
+    template <>
+    struct DileptonChannel<flavour::El, flavour::Mu>: public DifferentFlavourDileptonChannel {
+        using Flavour1 = flavour::El;
+        using Flavour2 = flavour::Mu;
+        static const char* name() { return "electron-muon"; }
+
+        static constexpr float dzFilterEfficiency() { return 0.982; }
+        static constexpr bool hasL1EMTFBug = false;
+        static constexpr float l1EMTFBugEfficiency() { return 1; }
+    };
+
+    using MuMuChannel = DileptonChannel<flavour::Mu, flavour::Mu>;
+    using ElElChannel = DileptonChannel<flavour::El, flavour::El>;
+    using MuElChannel = DileptonChannel<flavour::Mu, flavour::El>;
+    using ElMuChannel = DileptonChannel<flavour::El, flavour::Mu>;
+
+    // Call f(Channel()) with the channel of the two leptons, once per pair. Returns false, without calling f, if one
+    // of the leptons is neither a muon nor an electron
+    template <typename Function>
+    bool dispatchDileptonChannel(const Lepton& lep1, const Lepton& lep2, Function&& f) {
+        if (lep1.isMu && lep2.isMu)
+            f(MuMuChannel());
+        else if (lep1.isEl && lep2.isEl)
+            f(ElElChannel());
+        else if (lep1.isMu && lep2.isEl)
+            f(MuElChannel());
+        else if (lep1.isEl && lep2.isMu)
+            f(ElMuChannel());
+        else
+            return false;
+        return true;
+    }
+}
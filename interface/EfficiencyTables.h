@@ -0,0 +1,102 @@
+#pragma once
+
+// Generated by scripts/generateEfficiencyTables.py from the JSON files below, do not edit
+
+#include <cp3_llbb/HHAnalysis/interface/CompiledBinnedValues.h>
+
+namespace HH {
+namespace efficiency_tables {
+
+    // data/Efficiencies/Electron_IsoEle12Leg.json
+    constexpr float Electron_IsoEle12Leg_x[] = {-2.5f, -2.f, -1.56599998f, -1.44400001f, -0.800000012f, 0.f, 0.800000012f, 1.44400001f, 1.56599998f, 2.f, 2.5f};
+    constexpr float Electron_IsoEle12Leg_y[] = {0.f, 11.f, 11.5f, 11.75f, 12.f, 12.25f, 12.5f, 13.f, 15.f, 20.f, 35.f, 50.f, 90.f, 150.f, 500.f};
+    constexpr EfficiencyValue Electron_IsoEle12Leg_values[] = {
+        {0.0059518558f, 0.00187675655f, 0.00187675655f}, {0.0214083139f, 0.01191092f, 0.01191092f}, {0.0345496535f, 0.0145489927f, 0.0145489927f}, {0.128482297f, 0.0353859887f, 0.0353859887f}, {0.137972817f, 0.137972817f, 0.137972817f}, {0.323031217f, 0.0942186415f, 0.0942186415f}, {0.50914675f, 0.0888219923f, 0.0888219923f}, {0.703777671f, 0.0273038782f, 0.0273038782f}, {0.86566937f, 0.0126465121f, 0.0126465121f}, {0.955508232f, 0.00300478027f, 0.00300478027f}, {0.978104413f, 0.00140275387f, 0.00140275387f}, {0.988077879f, 0.00291160028f, 0.00291160028f}, {0.995723069f, 0.00427690148f, 0.00427690148f}, {0.995480537f, 0.0026218493f, 0.0026218493f},
+        {0.00476380298f, 0.00424621534f, 0.00424621534f}, {0.0811019018f, 0.0205383338f, 0.0205383338f}, {0.149192959f, 0.0413688198f, 0.0413688198f}, {0.241867617f, 0.03356627f, 0.03356627f}, {0.330617934f, 0.0872673616f, 0.0872673616f}, {0.504606962f, 0.135656253f, 0.135656253f}, {0.571463466f, 0.025344383f, 0.025344383f}, {0.7441324f, 0.0106227687f, 0.0106227687f}, {0.933832765f, 0.0113747809f, 0.0113747809f}, {0.978772521f, 0.00218797498f, 0.00218797498f}, {0.98731786f, 0.00104488072f, 0.00104488072f}, {0.989521205f, 0.00117460045f, 0.00117460045f}, {0.995328069f, 0.00101037743f, 0.00101037743f}, {0.998233259f, 0.00101133622f, 0.00101133622f},
+        {0.0101512903f, 0.0101512903f, 0.0101512903f}, {0.0867348239f, 0.0483353101f, 0.0483353101f}, {0.13333334f, 0.0860513374f, 0.0860513374f}, {0.216216221f, 0.0897288322f, 0.0897288322f}, {0.384615391f, 0.0881328657f, 0.0881328657f}, {0.448979586f, 0.0839658305f, 0.0839658305f}, {0.512437522f, 0.0752629861f, 0.0752629861f}, {0.75668937f, 0.0567040481f, 0.0567040481f}, {0.948760331f, 0.0461767763f, 0.0461767763f}, {0.968180358f, 0.00777765037f, 0.00777765037f}, {0.973205507f, 0.00225149607f, 0.00225149607f}, {0.971753657f, 0.00338991662f, 0.00338991662f}, {0.962972045f, 0.0107377479f, 0.0107377479f}, {0.966416001f, 0.0119490549f, 0.0119490549f},
+        {0.00445961067f, 0.00216300995f, 0.00216300995f}, {0.055477079f, 0.0132513214f, 0.0132513214f}, {0.173328653f, 0.059027344f, 0.059027344f}, {0.308672011f, 0.0357135013f, 0.0357135013f}, {0.422091603f, 0.0945268795f, 0.0945268795f}, {0.5705567f, 0.120792776f, 0.120792776f}, {0.715106726f, 0.0492453277f, 0.0492453277f}, {0.857059479f, 0.00729222875f, 0.00729222875f}, {0.932705343f, 0.00310883857f, 0.00310883857f}, {0.957544029f, 0.00171455601f, 0.00171455601f}, {0.970193088f, 0.00104874012f, 0.00104874012f}, {0.974805832f, 0.00307921227f, 0.00307921227f}, {0.983295381f, 0.00234770053f, 0.00234770053f}, {0.978916585f, 0.00228820136f, 0.00228820136f},
+        {0.0117547195f, 0.00850430038f, 0.00850430038f}, {0.0751570985f, 0.0256276261f, 0.0256276261f}, {0.106870659f, 0.0506698862f, 0.0506698862f}, {0.333123326f, 0.0591932312f, 0.0591932312f}, {0.569391012f, 0.0480362438f, 0.0480362438f}, {0.631049991f, 0.0427534804f, 0.0427534804f}, {0.812104881f, 0.0640986934f, 0.0640986934f}, {0.891895294f, 0.0177559666f, 0.0177559666f}, {0.932748497f, 0.00188227009f, 0.00188227009f}, {0.955209017f, 0.00913455058f, 0.00913455058f}, {0.966351807f, 0.00204114686f, 0.00204114686f}, {0.974327028f, 0.00149239262f, 0.00149239262f}, {0.978723347f, 0.0011844543f, 0.0011844543f}, {0.981231689f, 0.00375441252f, 0.00375441252f},
+        {0.00584344147f, 0.00421009818f, 0.00421009818f}, {0.0699902996f, 0.0153069664f, 0.0153069664f}, {0.245713636f, 0.0823381171f, 0.0823381171f}, {0.319764078f, 0.0532077961f, 0.0532077961f}, {0.540405214f, 0.0753769353f, 0.0753769353f}, {0.691241622f, 0.0366623737f, 0.0366623737f}, {0.759416759f, 0.0260309279f, 0.0260309279f}, {0.895329773f, 0.00588113535f, 0.00588113535f}, {0.921963453f, 0.00234044017f, 0.00234044017f}, {0.942712128f, 0.00661473768f, 0.00661473768f}, {0.959549308f, 0.00100076932f, 0.00100076932f}, {0.966906905f, 0.00155961397f, 0.00155961397f}, {0.972278893f, 0.00106713222f, 0.00106713222f}, {0.972715557f, 0.00259700906f, 0.00259700906f},
+        {0.00165605918f, 0.00107955886f, 0.00107955886f}, {0.0407541618f, 0.0170366149f, 0.0170366149f}, {0.188216031f, 0.0263901632f, 0.0263901632f}, {0.239128858f, 0.138685018f, 0.138685018f}, {0.469083458f, 0.0361979045f, 0.0361979045f}, {0.451277673f, 0.148409709f, 0.148409709f}, {0.635132492f, 0.0695365742f, 0.0695365742f}, {0.871142805f, 0.0294916984f, 0.0294916984f}, {0.94156146f, 0.00591517892f, 0.00591517892f}, {0.960641563f, 0.00219654897f, 0.00219654897f}, {0.973104477f, 0.00131924858f, 0.00131924858f}, {0.975410819f, 0.00109584874f, 0.00109584874f}, {0.984103262f, 0.00187565538f, 0.00187565538f}, {0.984712422f, 0.00235883566f, 0.00235883566f},
+        {0.00100000005f, 0.00100000005f, 0.00100000005f}, {0.0515407622f, 0.0337138958f, 0.0337138958f}, {0.0799999982f, 0.0631384999f, 0.0631384999f}, {0.285714298f, 0.0859066248f, 0.0859066248f}, {0.303030312f, 0.083015576f, 0.083015576f}, {0.388888896f, 0.27103883f, 0.27103883f}, {0.310467839f, 0.1312453f, 0.1312453f}, {0.688536763f, 0.0563425198f, 0.0563425198f}, {0.891115606f, 0.0406652391f, 0.0406652391f}, {0.974903584f, 0.00536897872f, 0.00536897872f}, {0.980609179f, 0.00289448863f, 0.00289448863f}, {0.979336083f, 0.00180145446f, 0.00180145446f}, {0.969072819f, 0.0101983612f, 0.0101983612f}, {0.911390364f, 0.0624202117f, 0.0624202117f},
+        {0.0021145728f, 0.00156561122f, 0.00156561122f}, {0.0465319231f, 0.0235953964f, 0.0235953964f}, {0.20290567f, 0.122121356f, 0.122121356f}, {0.208113879f, 0.0342018344f, 0.0342018344f}, {0.224609882f, 0.224609882f, 0.224609882f}, {0.3814013f, 0.0436721258f, 0.0436721258f}, {0.486403018f, 0.0539526157f, 0.0539526157f}, {0.752913415f, 0.0327222496f, 0.0327222496f}, {0.908803225f, 0.0155695565f, 0.0155695565f}, {0.978707016f, 0.00239006476f, 0.00239006476f}, {0.988114953f, 0.00103330053f, 0.00103330053f}, {0.987268746f, 0.00414762134f, 0.00414762134f}, {0.997598469f, 0.00116447825f, 0.00116447825f}, {0.999186277f, 0.000813731982f, 0.000813731982f},
+        {0.00231680879f, 0.00136241049f, 0.00136241049f}, {0.0228328332f, 0.00894387905f, 0.00894387905f}, {0.0417641178f, 0.0149325812f, 0.0149325812f}, {0.0919908732f, 0.0919908732f, 0.0919908732f}, {0.160494506f, 0.0669881478f, 0.0669881478f}, {0.290899515f, 0.0737116039f, 0.0737116039f}, {0.484038115f, 0.0850693434f, 0.0850693434f}, {0.66876477f, 0.0173659232f, 0.0173659232f}, {0.822910547f, 0.00755932182f, 0.00755932182f}, {0.940483809f, 0.00246050605f, 0.00246050605f}, {0.976388991f, 0.00120561931f, 0.00120561931f}, {0.98793143f, 0.00396779785f, 0.00396779785f}, {0.994177222f, 0.00123779231f, 0.00123779231f}, {0.997707486f, 0.0022925064f, 0.0022925064f},
+    };
+    constexpr CompiledBinnedValues Electron_IsoEle12Leg = {{BinningVariable::Eta, Electron_IsoEle12Leg_x, 10}, {BinningVariable::Pt, Electron_IsoEle12Leg_y, 14}, Electron_IsoEle12Leg_values, nullptr};
+
+    // data/Efficiencies/Electron_IsoEle23Leg.json
+    constexpr float Electron_IsoEle23Leg_x[] = {-2.5f, -2.f, -1.56599998f, -1.44400001f, -0.800000012f, 0.f, 0.800000012f, 1.44400001f, 1.56599998f, 2.f, 2.5f};
+    constexpr float Electron_IsoEle23Leg_y[] = {0.f, 22.f, 22.5f, 22.75f, 23.f, 23.25f, 23.5f, 24.f, 25.f, 30.f, 35.f, 50.f, 90.f, 150.f, 500.f};
+    constexpr EfficiencyValue Electron_IsoEle23Leg_values[] = {
+        {0.0065841903f, 0.00108553632f, 0.00108553632f}, {0.0783688426f, 0.0173590481f, 0.0173590481f}, {0.15609616f, 0.0127627132f, 0.0127627132f}, {0.209547341f, 0.0285303593f, 0.0285303593f}, {0.31468752f, 0.024976993f, 0.024976993f}, {0.39093405f, 0.0387241766f, 0.0387241766f}, {0.482014835f, 0.035101898f, 0.035101898f}, {0.704747975f, 0.0198382046f, 0.0198382046f}, {0.932465076f, 0.00714653777f, 0.00714653777f}, {0.968853712f, 0.00324457651f, 0.00324457651f}, {0.977855325f, 0.00122319697f, 0.00122319697f}, {0.987462938f, 0.0021356924f, 0.0021356924f}, {0.995723069f, 0.00427690148f, 0.00427690148f}, {0.995480537f, 0.0026218493f, 0.0026218493f},
+        {0.0133326603f, 0.00276091089f, 0.00276091089f}, {0.240768f, 0.0149053736f, 0.0149053736f}, {0.332892865f, 0.0260838661f, 0.0260838661f}, {0.484019697f, 0.0290735587f, 0.0290735587f}, {0.57323581f, 0.0161494501f, 0.0161494501f}, {0.646064639f, 0.035815306f, 0.035815306f}, {0.799215376f, 0.0262444355f, 0.0262444355f}, {0.900521994f, 0.012052374f, 0.012052374f}, {0.975405335f, 0.00511935353f, 0.00511935353f}, {0.98062396f, 0.00192616554f, 0.00192616554f}, {0.987207949f, 0.00124458747f, 0.00124458747f}, {0.990088403f, 0.00103348459f, 0.00103348459f}, {0.995328069f, 0.00101037743f, 0.00101037743f}, {0.998233259f, 0.00101133622f, 0.00101133622f},
+        {0.0887022167f, 0.0372895896f, 0.0372895896f}, {0.265184939f, 0.0432642587f, 0.0432642587f}, {0.259273112f, 0.139021039f, 0.139021039f}, {0.490043491f, 0.0372203179f, 0.0372203179f}, {0.519297659f, 0.0738501474f, 0.0738501474f}, {0.434809119f, 0.1588597f, 0.1588597f}, {0.795005977f, 0.0835903957f, 0.0835903957f}, {0.822640777f, 0.0182297863f, 0.0182297863f}, {0.951631129f, 0.00942318141f, 0.00942318141f}, {0.96555084f, 0.00477995118f, 0.00477995118f}, {0.973310947f, 0.00245550298f, 0.00245550298f}, {0.974317729f, 0.0024521891f, 0.0024521891f}, {0.962972045f, 0.0107377479f, 0.0107377479f}, {0.966416001f, 0.0119490549f, 0.0119490549f},
+        {0.00298062316f, 0.00298062316f, 0.00298062316f}, {0.0845984742f, 0.0227098335f, 0.0227098335f}, {0.185003564f, 0.0416643173f, 0.0416643173f}, {0.309226364f, 0.00967279822f, 0.00967279822f}, {0.434495479f, 0.0351262391f, 0.0351262391f}, {0.554307342f, 0.0300448015f, 0.0300448015f}, {0.69839561f, 0.00774307363f, 0.00774307363f}, {0.847595811f, 0.0185564477f, 0.0185564477f}, {0.946251988f, 0.00421886565f, 0.00421886565f}, {0.962717772f, 0.00326106581f, 0.00326106581f}, {0.970278025f, 0.0010998575f, 0.0010998575f}, {0.973632395f, 0.00181303849f, 0.00181303849f}, {0.983295381f, 0.00234770053f, 0.00234770053f}, {0.978916585f, 0.00228820136f, 0.00228820136f},
+        {0.00591173628f, 0.00242710952f, 0.00242710952f}, {0.11921066f, 0.00540116569f, 0.00540116569f}, {0.252604961f, 0.0100999707f, 0.0100999707f}, {0.373977214f, 0.00909224246f, 0.00909224246f}, {0.556029439f, 0.0358029604f, 0.0358029604f}, {0.69623524f, 0.00810259581f, 0.00810259581f}, {0.827089429f, 0.0162961185f, 0.0162961185f}, {0.913077593f, 0.003065011f, 0.003065011f}, {0.943753898f, 0.00569629204f, 0.00569629204f}, {0.955236316f, 0.00222453964f, 0.00222453964f}, {0.968106329f, 0.00122528058f, 0.00122528058f}, {0.974327564f, 0.0014963164f, 0.0014963164f}, {0.978723347f, 0.0011844543f, 0.0011844543f}, {0.981231689f, 0.00375441252f, 0.00375441252f},
+        {0.00567478407f, 0.00261595775f, 0.00261595775f}, {0.108543895f, 0.0267117787f, 0.0267117787f}, {0.238316581f, 0.026300177f, 0.026300177f}, {0.387390763f, 0.0120827584f, 0.0120827584f}, {0.550106823f, 0.0167807955f, 0.0167807955f}, {0.685635209f, 0.0524399877f, 0.0524399877f}, {0.821254432f, 0.0141202724f, 0.0141202724f}, {0.905521631f, 0.00273529207f, 0.00273529207f}, {0.935707092f, 0.00155048654f, 0.00155048654f}, {0.946485639f, 0.00210532732f, 0.00210532732f}, {0.959549308f, 0.00100076932f, 0.00100076932f}, {0.966906905f, 0.00155961397f, 0.00155961397f}, {0.972278893f, 0.00106713222f, 0.00106713222f}, {0.972715557f, 0.00259700906f, 0.00259700906f},
+        {0.00332248094f, 0.00142217905f, 0.00142217905f}, {0.0668475851f, 0.0147818569f, 0.0147818569f}, {0.167390198f, 0.00848203246f, 0.00848203246f}, {0.267243862f, 0.0136675211f, 0.0136675211f}, {0.399146259f, 0.0343382582f, 0.0343382582f}, {0.534652591f, 0.0102826077f, 0.0102826077f}, {0.691125214f, 0.0217926875f, 0.0217926875f}, {0.859473407f, 0.0110187894f, 0.0110187894f}, {0.946434438f, 0.00317656808f, 0.00317656808f}, {0.964665771f, 0.00282544992f, 0.00282544992f}, {0.973213911f, 0.00145242584f, 0.00145242584f}, {0.975408614f, 0.00106431509f, 0.00106431509f}, {0.984103262f, 0.00187565538f, 0.00187565538f}, {0.984712422f, 0.00235883566f, 0.00235883566f},
+        {0.0794251859f, 0.00602821261f, 0.00602821261f}, {0.301911056f, 0.0599368736f, 0.0599368736f}, {0.320091367f, 0.0465749875f, 0.0465749875f}, {0.399072051f, 0.0817541108f, 0.0817541108f}, {0.53198266f, 0.0780188069f, 0.0780188069f}, {0.563389778f, 0.0639806166f, 0.0639806166f}, {0.619321048f, 0.100593947f, 0.100593947f}, {0.850210547f, 0.0639909655f, 0.0639909655f}, {0.939109206f, 0.00409057084f, 0.00409057084f}, {0.975806057f, 0.00430182274f, 0.00430182274f}, {0.980685055f, 0.00315404846f, 0.00315404846f}, {0.982022643f, 0.0041462942f, 0.0041462942f}, {0.969072819f, 0.0101983612f, 0.0101983612f}, {0.911390364f, 0.0624202117f, 0.0624202117f},
+        {0.0112630157f, 0.00188075518f, 0.00188075518f}, {0.145707682f, 0.0458389521f, 0.0458389521f}, {0.248940572f, 0.0310740322f, 0.0310740322f}, {0.374896228f, 0.0420716777f, 0.0420716777f}, {0.466215909f, 0.0358498208f, 0.0358498208f}, {0.627845943f, 0.0340649001f, 0.0340649001f}, {0.754009247f, 0.0256864224f, 0.0256864224f}, {0.898198605f, 0.0157360025f, 0.0157360025f}, {0.972977996f, 0.00514449319f, 0.00514449319f}, {0.98471272f, 0.00391448895f, 0.00391448895f}, {0.988130391f, 0.00104393542f, 0.00104393542f}, {0.990428984f, 0.00144797971f, 0.00144797971f}, {0.997598469f, 0.00116447825f, 0.00116447825f}, {0.999186277f, 0.000813731982f, 0.000813731982f},
+        {0.00558174588f, 0.00117698032f, 0.00117698032f}, {0.0749845579f, 0.00942114461f, 0.00942114461f}, {0.110031717f, 0.0261914395f, 0.0261914395f}, {0.183454975f, 0.033716619f, 0.033716619f}, {0.259167463f, 0.0220987536f, 0.0220987536f}, {0.335210532f, 0.0218369029f, 0.0218369029f}, {0.443859756f, 0.0197678115f, 0.0197678115f}, {0.699961066f, 0.0124103017f, 0.0124103017f}, {0.912204325f, 0.00805252232f, 0.00805252232f}, {0.961796463f, 0.00292586116f, 0.00292586116f}, {0.976415217f, 0.00112625747f, 0.00112625747f}, {0.986509144f, 0.00212334399f, 0.00212334399f}, {0.994152129f, 0.00160813518f, 0.00160813518f}, {0.9980492f, 0.00195079844f, 0.00195079844f},
+    };
+    constexpr CompiledBinnedValues Electron_IsoEle23Leg = {{BinningVariable::Eta, Electron_IsoEle23Leg_x, 10}, {BinningVariable::Pt, Electron_IsoEle23Leg_y, 14}, Electron_IsoEle23Leg_values, nullptr};
+
+    // data/Efficiencies/Muon_DoubleIsoMu17Mu8_IsoMu17leg.json
+    constexpr float Muon_DoubleIsoMu17Mu8_IsoMu17leg_x[] = {0.f, 0.899999976f, 1.20000005f, 2.0999999f, 2.4000001f};
+    constexpr float Muon_DoubleIsoMu17Mu8_IsoMu17leg_y[] = {0.f, 16.f, 16.5f, 16.75f, 17.f, 17.25f, 17.5f, 18.f, 20.f, 25.f, 30.f, 40.f, 50.f, 60.f, 80.f, 120.f, 200.f, 500.f};
+    constexpr EfficiencyValue Muon_DoubleIsoMu17Mu8_IsoMu17leg_values[] = {
+        {0.000150901411f, 5.78098152e-05f, 7.79993425e-05f}, {0.00350791798f, 0.000724460289f, 0.000813195307f}, {0.0122813908f, 0.00202974398f, 0.00211322913f}, {0.112962663f, 0.00576444622f, 0.00589642953f}, {0.764973938f, 0.010581742f, 0.0105811628f}, {0.914073706f, 0.0102128433f, 0.0102026304f}, {0.928280652f, 0.00974572729f, 0.00972494949f}, {0.934926033f, 0.00942762289f, 0.00942647737f}, {0.935773611f, 0.0093704313f, 0.00937075727f}, {0.935317338f, 0.00935813878f, 0.00935811829f}, {0.933507264f, 0.00933602732f, 0.00933603942f}, {0.932521105f, 0.00932587963f, 0.00932588708f}, {0.931453228f, 0.00931754708f, 0.00931755733f}, {0.929490268f, 0.00930280332f, 0.0093027046f}, {0.926507533f, 0.0093028117f, 0.00930228177f}, {0.92025876f, 0.00951766223f, 0.00950879697f}, {0.902996182f, 0.0128113246f, 0.0124833388f},
+        {0.00122044876f, 0.000250693847f, 0.000276921754f}, {0.0122860875f, 0.00234622532f, 0.00208149478f}, {0.0211961623f, 0.00375115732f, 0.00408508256f}, {0.121413417f, 0.0077560842f, 0.00803032517f}, {0.730539858f, 0.0129696f, 0.0130923968f}, {0.893181562f, 0.0121018915f, 0.0119993407f}, {0.90187782f, 0.0100598112f, 0.010007971f}, {0.921271265f, 0.00941152684f, 0.00940760877f}, {0.929842293f, 0.00933361053f, 0.00933405571f}, {0.932962358f, 0.00934549607f, 0.00934557337f}, {0.931911707f, 0.00932265539f, 0.00932264701f}, {0.932664037f, 0.00932903588f, 0.00932903588f}, {0.931678712f, 0.00932750758f, 0.00932745822f}, {0.930579185f, 0.00933362171f, 0.00933329575f}, {0.926926732f, 0.00940433796f, 0.00940187555f}, {0.912130237f, 0.0104714651f, 0.010406157f}, {0.89631629f, 0.0214084256f, 0.0194864608f},
+        {0.00168430666f, 0.000139961208f, 0.000144593738f}, {0.0172543731f, 0.0012464734f, 0.00128999015f}, {0.0437765382f, 0.00256802887f, 0.00263244379f}, {0.154109463f, 0.00449734554f, 0.0045262645f}, {0.598389685f, 0.00810953602f, 0.00810881052f}, {0.828240693f, 0.0092952745f, 0.00930845272f}, {0.875216305f, 0.00909868535f, 0.00908853114f}, {0.897319019f, 0.00903206784f, 0.00903162174f}, {0.917149723f, 0.00918257423f, 0.00918252114f}, {0.92533052f, 0.00925878994f, 0.00925876759f}, {0.930078268f, 0.00930221844f, 0.00930221938f}, {0.932386994f, 0.009324966f, 0.00932496414f}, {0.929649055f, 0.00930164196f, 0.00930164382f}, {0.921640158f, 0.00923110824f, 0.00923134945f}, {0.907783747f, 0.00916303042f, 0.00916197244f}, {0.892442226f, 0.00980123691f, 0.00977638829f}, {0.906777978f, 0.020689141f, 0.0192691572f},
+        {0.00363617484f, 0.000303791137f, 0.000314488891f}, {0.0296431389f, 0.00264139287f, 0.00278552668f}, {0.0617325269f, 0.00499464478f, 0.00634619407f}, {0.198133945f, 0.0074834465f, 0.00761928875f}, {0.430310756f, 0.010293128f, 0.0103920661f}, {0.643912077f, 0.0114216162f, 0.0113351801f}, {0.715502381f, 0.00921025872f, 0.00921064056f}, {0.768924356f, 0.00810396206f, 0.00808983389f}, {0.822666466f, 0.0083087692f, 0.00830873568f}, {0.853842139f, 0.00857571885f, 0.00857556239f}, {0.876273572f, 0.00877302978f, 0.00877302326f}, {0.89049089f, 0.00891470816f, 0.00891462341f}, {0.894149721f, 0.00898757204f, 0.00898693781f}, {0.899747193f, 0.00911693368f, 0.00911665242f}, {0.90587765f, 0.00968346465f, 0.00966454204f}, {0.888126194f, 0.0157262199f, 0.015480536f}, {0.999940991f, 0.916346312f, 5.90015734e-05f},
+    };
+    constexpr CompiledBinnedValues Muon_DoubleIsoMu17Mu8_IsoMu17leg = {{BinningVariable::AbsEta, Muon_DoubleIsoMu17Mu8_IsoMu17leg_x, 4}, {BinningVariable::Pt, Muon_DoubleIsoMu17Mu8_IsoMu17leg_y, 17}, Muon_DoubleIsoMu17Mu8_IsoMu17leg_values, nullptr};
+
+    // data/Efficiencies/Muon_DoubleIsoMu17TkMu8_IsoMu8legORTkMu8leg.json
+    constexpr float Muon_DoubleIsoMu17TkMu8_IsoMu8legORTkMu8leg_x[] = {0.f, 0.899999976f, 1.20000005f, 2.0999999f, 2.4000001f};
+    constexpr float Muon_DoubleIsoMu17TkMu8_IsoMu8legORTkMu8leg_y[] = {0.f, 7.5f, 7.75f, 8.f, 8.25f, 8.5f, 9.f, 10.f, 12.f, 15.f, 20.f, 30.f, 40.f, 50.f, 60.f, 80.f, 120.f, 200.f, 500.f};
+    constexpr EfficiencyValue Muon_DoubleIsoMu17TkMu8_IsoMu8legORTkMu8leg_values[] = {
+        {0.f, 0.f, 0.00501724938f}, {1.25816046e-09f, 1.25816046e-09f, 0.0166754276f}, {0.0222481824f, 0.0191749819f, 0.0268733092f}, {0.871400237f, 0.0351558924f, 0.030297393f}, {0.954582036f, 0.0299655739f, 0.0251754075f}, {0.970768809f, 0.0170397498f, 0.0152427712f}, {0.952022076f, 0.0128875468f, 0.0124700107f}, {0.958765328f, 0.0102173071f, 0.0101797637f}, {0.954248726f, 0.00971129537f, 0.00970598776f}, {0.95219475f, 0.00955291837f, 0.00955267902f}, {0.950894415f, 0.00951165333f, 0.00951164775f}, {0.949626803f, 0.00949699152f, 0.00949699897f}, {0.948090255f, 0.00948141981f, 0.00948141981f}, {0.947148383f, 0.00947379973f, 0.00947380811f}, {0.945662439f, 0.00946265366f, 0.00946268532f}, {0.943654597f, 0.0094651645f, 0.00946488418f}, {0.940870821f, 0.00964139029f, 0.00963484682f}, {0.927779317f, 0.0122666368f, 0.0119702462f},
+        {0.00144763128f, 0.00101009326f, 0.001972656f}, {0.00671506068f, 0.00468220841f, 0.0090944143f}, {0.0738472193f, 0.0192382112f, 0.0231985711f}, {0.81901139f, 0.0352263376f, 0.0328324698f}, {0.926695585f, 0.0229456834f, 0.0225161426f}, {0.954049706f, 0.0147118224f, 0.0137806199f}, {0.981341183f, 0.0106083164f, 0.0104960166f}, {0.977682769f, 0.010092861f, 0.010052219f}, {0.977780223f, 0.0098944772f, 0.00988872163f}, {0.976095259f, 0.0097916536f, 0.00979162101f}, {0.975541532f, 0.00975933298f, 0.00975930318f}, {0.973646402f, 0.00973782316f, 0.00973782782f}, {0.973326206f, 0.00973421335f, 0.00973420776f}, {0.972953498f, 0.00973385666f, 0.00973382313f}, {0.972669303f, 0.00973747857f, 0.00973764155f}, {0.972649813f, 0.00977662113f, 0.00977513287f}, {0.967183411f, 0.0102002267f, 0.0107296044f}, {0.972424984f, 0.0145729259f, 0.0156690571f},
+        {0.00143622723f, 0.000481190014f, 0.00056388817f}, {0.0163583588f, 0.00399356009f, 0.00473714573f}, {0.0704445466f, 0.00776138948f, 0.00888147578f}, {0.764320493f, 0.0158507526f, 0.0154522695f}, {0.928156555f, 0.0122003779f, 0.0118973339f}, {0.943445385f, 0.0105441948f, 0.0104211522f}, {0.958263278f, 0.00987892412f, 0.00987134594f}, {0.959317803f, 0.00969344098f, 0.00969282724f}, {0.961108923f, 0.00964985602f, 0.00964924227f}, {0.962053895f, 0.00963177439f, 0.00963172875f}, {0.96415031f, 0.0096431924f, 0.00964318309f}, {0.965077341f, 0.00965148304f, 0.00965149794f}, {0.966578603f, 0.00966632459f, 0.00966632925f}, {0.966733217f, 0.00966974441f, 0.00966976583f}, {0.966676772f, 0.00967308972f, 0.00967302918f}, {0.967238367f, 0.00970205106f, 0.00970151089f}, {0.966701746f, 0.00995485298f, 0.00993565284f}, {0.989280403f, 0.0123558678f, 0.0107196085f},
+        {0.00312531879f, 0.00098087138f, 0.00112578098f}, {0.0259033404f, 0.00671531959f, 0.00788525492f}, {0.11950884f, 0.0147246616f, 0.0144394245f}, {0.726324558f, 0.0212748274f, 0.0204775352f}, {0.884803474f, 0.0155933294f, 0.0148858866f}, {0.917381227f, 0.0119851297f, 0.0118268505f}, {0.940058649f, 0.0104221385f, 0.0103594577f}, {0.942549825f, 0.00978412572f, 0.00977445487f}, {0.944205403f, 0.00959360786f, 0.009591599f}, {0.947579384f, 0.00952128973f, 0.00952206179f}, {0.952549696f, 0.00953346863f, 0.00953342207f}, {0.955767453f, 0.00956143998f, 0.00956142042f}, {0.956789374f, 0.00957175996f, 0.00957172737f}, {0.95575577f, 0.00957730133f, 0.00957711693f}, {0.955409646f, 0.00960978772f, 0.0096091032f}, {0.960612953f, 0.00988549739f, 0.00987066515f}, {0.964493692f, 0.0142102661f, 0.0137421209f}, {1.f, 0.027737001f, 4.61142236e-12f},
+    };
+    constexpr CompiledBinnedValues Muon_DoubleIsoMu17TkMu8_IsoMu8legORTkMu8leg = {{BinningVariable::AbsEta, Muon_DoubleIsoMu17TkMu8_IsoMu8legORTkMu8leg_x, 4}, {BinningVariable::Pt, Muon_DoubleIsoMu17TkMu8_IsoMu8legORTkMu8leg_y, 18}, Muon_DoubleIsoMu17TkMu8_IsoMu8legORTkMu8leg_values, nullptr};
+
+    // data/Efficiencies/Muon_XPathIsoMu23leg.json
+    constexpr float Muon_XPathIsoMu23leg_x[] = {0.f, 0.899999976f, 1.20000005f, 2.0999999f, 2.4000001f};
+    constexpr float Muon_XPathIsoMu23leg_y[] = {0.f, 21.f, 22.5f, 22.75f, 23.f, 23.25f, 23.5f, 24.f, 25.f, 27.f, 30.f, 40.f, 50.f, 60.f, 80.f, 120.f, 200.f, 500.f};
+    constexpr EfficiencyValue Muon_XPathIsoMu23leg_values[] = {
+        {0.0001998238f, 4.29954671e-05f, 4.81308161e-05f}, {0.00470663793f, 0.000282345485f, 0.000287655712f}, {0.0229568165f, 0.00140037807f, 0.00142044155f}, {0.152501479f, 0.00340557541f, 0.00343160611f}, {0.698572755f, 0.00799649954f, 0.00799479056f}, {0.883586407f, 0.00923963916f, 0.00923418161f}, {0.909033537f, 0.00923709944f, 0.00923669059f}, {0.922681272f, 0.0092787873f, 0.00927856378f}, {0.928504407f, 0.00930299517f, 0.00930325687f}, {0.931273997f, 0.00932030752f, 0.00932027027f}, {0.931012392f, 0.00931111351f, 0.00931112748f}, {0.930368781f, 0.00930438191f, 0.00930438098f}, {0.929538608f, 0.00929848477f, 0.00929849502f}, {0.927805543f, 0.00928608701f, 0.00928608701f}, {0.924471855f, 0.00928352121f, 0.00928297732f}, {0.918406188f, 0.00950484443f, 0.00949830469f}, {0.902996182f, 0.0128113246f, 0.0124833388f},
+        {0.00111346983f, 0.00014090848f, 0.000147251296f}, {0.0107228952f, 0.000678954704f, 0.00069588382f}, {0.039170146f, 0.00272588292f, 0.00279524992f}, {0.155653507f, 0.00511751417f, 0.00517113181f}, {0.627470732f, 0.00896085054f, 0.00894809142f}, {0.833315134f, 0.00965440739f, 0.00963354204f}, {0.872724235f, 0.00923325215f, 0.00922578946f}, {0.88922745f, 0.0090931477f, 0.00908965897f}, {0.903139532f, 0.0091012558f, 0.00910164881f}, {0.914902329f, 0.00917857513f, 0.00917926338f}, {0.922062099f, 0.00922467001f, 0.00922465418f}, {0.925640821f, 0.0092590563f, 0.00925905071f}, {0.925329924f, 0.00926501211f, 0.00926496927f}, {0.92462641f, 0.00927643292f, 0.009276147f}, {0.921513438f, 0.00936003495f, 0.00935721118f}, {0.905660868f, 0.0104953256f, 0.0104226787f}, {0.889583111f, 0.021786103f, 0.0199647248f},
+        {0.00119385042f, 7.39544921e-05f, 7.53599306e-05f}, {0.0177087858f, 0.000484977994f, 0.000486894889f}, {0.064982295f, 0.00196846994f, 0.00197908888f}, {0.183873624f, 0.00334709371f, 0.0033533629f}, {0.502719939f, 0.00613816828f, 0.00613908097f}, {0.726059139f, 0.00787850656f, 0.00787883438f}, {0.789852321f, 0.00813595671f, 0.00812939275f}, {0.818234026f, 0.00827348232f, 0.00827383809f}, {0.840651214f, 0.00844007079f, 0.00844059605f}, {0.856886685f, 0.00858481135f, 0.00858479552f}, {0.872962296f, 0.00873222854f, 0.00873222575f}, {0.881244421f, 0.00881437026f, 0.0088143656f}, {0.879950345f, 0.00880834647f, 0.00880833808f}, {0.872344613f, 0.00874767266f, 0.00874758232f}, {0.860324025f, 0.00872961059f, 0.00873014703f}, {0.846275628f, 0.00969450921f, 0.00966491923f}, {0.854240239f, 0.0234280955f, 0.0221182033f},
+        {0.00370803475f, 0.000192194289f, 0.00019745421f}, {0.0303070396f, 0.00110284518f, 0.00111514516f}, {0.108434692f, 0.00425035693f, 0.00429145247f}, {0.207964167f, 0.00555897225f, 0.00558968727f}, {0.338159204f, 0.00706907082f, 0.00707295025f}, {0.469243258f, 0.00791038666f, 0.00795459747f}, {0.571648061f, 0.00721753296f, 0.00721866498f}, {0.628252625f, 0.00689153373f, 0.00688979588f}, {0.666576803f, 0.00689982902f, 0.00690125627f}, {0.708590806f, 0.00719809765f, 0.00719849579f}, {0.760757923f, 0.00762730092f, 0.00762726041f}, {0.789124131f, 0.00791014172f, 0.00790861994f}, {0.797769308f, 0.00806214567f, 0.0080612367f}, {0.805442989f, 0.00827732217f, 0.00827765279f}, {0.811085403f, 0.00927510671f, 0.00925506558f}, {0.800016284f, 0.017790094f, 0.0177911837f}, {0.828263819f, 0.0942399576f, 0.078342773f},
+    };
+    constexpr CompiledBinnedValues Muon_XPathIsoMu23leg = {{BinningVariable::AbsEta, Muon_XPathIsoMu23leg_x, 4}, {BinningVariable::Pt, Muon_XPathIsoMu23leg_y, 17}, Muon_XPathIsoMu23leg_values, nullptr};
+
+    // data/Efficiencies/Muon_XPathIsoMu8leg.json
+    constexpr float Muon_XPathIsoMu8leg_x[] = {0.f, 0.899999976f, 1.20000005f, 2.0999999f, 2.4000001f};
+    constexpr float Muon_XPathIsoMu8leg_y[] = {0.f, 7.5f, 7.75f, 8.f, 8.25f, 8.5f, 9.f, 10.f, 12.f, 15.f, 20.f, 30.f, 40.f, 50.f, 60.f, 80.f, 120.f, 200.f, 500.f};
+    constexpr EfficiencyValue Muon_XPathIsoMu8leg_values[] = {
+        {0.f, 0.f, 0.00501724938f}, {1.25816046e-09f, 1.25816046e-09f, 0.0166754276f}, {0.0222481824f, 0.0191749819f, 0.0268733092f}, {0.863289893f, 0.0357712619f, 0.0310879946f}, {0.955657661f, 0.0297033805f, 0.0250088163f}, {0.958171368f, 0.0183864385f, 0.0166912302f}, {0.93816787f, 0.0138790011f, 0.013362173f}, {0.945623457f, 0.010262507f, 0.0102333548f}, {0.939656794f, 0.00961843599f, 0.00961185526f}, {0.93905127f, 0.00943094585f, 0.00943036377f}, {0.939660013f, 0.00939995144f, 0.00939994119f}, {0.937569499f, 0.00937659387f, 0.00937660038f}, {0.936698198f, 0.00936792977f, 0.0093679307f}, {0.935886264f, 0.00936168246f, 0.00936169457f}, {0.934266448f, 0.00935001299f, 0.00934998784f}, {0.931342483f, 0.00934851915f, 0.00934802648f}, {0.924812376f, 0.00954016298f, 0.00953373499f}, {0.909768581f, 0.0126567725f, 0.0123380069f},
+        {0.f, 0.f, 0.0026767035f}, {0.00671506068f, 0.00468220841f, 0.0090944143f}, {0.0610710606f, 0.0173054524f, 0.0212952457f}, {0.78805995f, 0.0365024246f, 0.0344904587f}, {0.9163028f, 0.0237534046f, 0.0211520456f}, {0.948121369f, 0.0158278868f, 0.0148938503f}, {0.939906716f, 0.0125341518f, 0.0120950239f}, {0.940759897f, 0.0102168228f, 0.0101633118f}, {0.948020577f, 0.00976537261f, 0.0097638825f}, {0.947263658f, 0.00954076368f, 0.00954040047f}, {0.953671813f, 0.00954419933f, 0.00954415649f}, {0.953222275f, 0.00953465048f, 0.00953465328f}, {0.954036355f, 0.00954166427f, 0.00954166427f}, {0.954002619f, 0.00954729784f, 0.0095472578f}, {0.955135822f, 0.00956928916f, 0.00956902467f}, {0.95407778f, 0.00962160528f, 0.00962128956f}, {0.944195926f, 0.0103182299f, 0.0102626979f}, {0.956147194f, 0.0163524523f, 0.0146782212f},
+        {0.00162546022f, 0.000598164974f, 0.000453856192f}, {0.0151268961f, 0.00452382769f, 0.00393116288f}, {0.0682846382f, 0.00773801096f, 0.0086165946f}, {0.701244593f, 0.0162647925f, 0.0158718899f}, {0.86555779f, 0.0133972308f, 0.0130642895f}, {0.865842342f, 0.0112064248f, 0.0109746056f}, {0.872916639f, 0.00967793632f, 0.00965572055f}, {0.879491031f, 0.00909394026f, 0.00909490697f}, {0.887180865f, 0.0089835776f, 0.0089861583f}, {0.892004073f, 0.00895123463f, 0.00895114802f}, {0.897668839f, 0.00898146071f, 0.00898155943f}, {0.900517106f, 0.00900720339f, 0.00900720805f}, {0.902465761f, 0.00902625639f, 0.00902621914f}, {0.898752213f, 0.00899498351f, 0.00899498444f}, {0.888119936f, 0.00890244171f, 0.00890229642f}, {0.871349931f, 0.00882771332f, 0.00882842299f}, {0.855616808f, 0.00972906966f, 0.00970836822f}, {0.841710508f, 0.0219639521f, 0.0499055535f},
+        {0.00192292314f, 0.000789697864f, 0.000930626004f}, {0.0163891651f, 0.00443102699f, 0.00540009513f}, {0.0976932123f, 0.0123688327f, 0.0131464871f}, {0.63317132f, 0.0220225193f, 0.0215657484f}, {0.767347336f, 0.0229734052f, 0.0182757489f}, {0.78979826f, 0.0140996967f, 0.0238686129f}, {0.804252207f, 0.0110343304f, 0.0109252175f}, {0.817132771f, 0.00935145002f, 0.009265339f}, {0.828882873f, 0.00873201247f, 0.00872992538f}, {0.837285459f, 0.00851338729f, 0.00851008482f}, {0.848804414f, 0.00851255748f, 0.00851245318f}, {0.854671717f, 0.00855871383f, 0.00855862256f}, {0.855927646f, 0.00857213605f, 0.00857207738f}, {0.854862273f, 0.00860921759f, 0.00860862248f}, {0.857631028f, 0.00874008331f, 0.00874067657f}, {0.863331199f, 0.00950102229f, 0.00948225893f}, {0.84762305f, 0.0166426618f, 0.0168651249f}, {0.863353789f, 0.085731633f, 0.0666626245f},
+    };
+    constexpr CompiledBinnedValues Muon_XPathIsoMu8leg = {{BinningVariable::AbsEta, Muon_XPathIsoMu8leg_x, 4}, {BinningVariable::Pt, Muon_XPathIsoMu8leg_y, 18}, Muon_XPathIsoMu8leg_values, nullptr};
+
+    // Tables by path of the JSON file, as given to edm::FileInPath, with the hash of the file they were generated from
+    constexpr struct {
+        const char* path;
+        const CompiledBinnedValues* table;
+        uint64_t hash;
+    } all[] = {
+        {"cp3_llbb/HHAnalysis/data/Efficiencies/Electron_IsoEle12Leg.json", &Electron_IsoEle12Leg, 0xb56dc57d95179a7eull},
+        {"cp3_llbb/HHAnalysis/data/Efficiencies/Electron_IsoEle23Leg.json", &Electron_IsoEle23Leg, 0xb4694f09555604d5ull},
+        {"cp3_llbb/HHAnalysis/data/Efficiencies/Muon_DoubleIsoMu17Mu8_IsoMu17leg.json", &Muon_DoubleIsoMu17Mu8_IsoMu17leg, 0x0ac75bb20cc25186ull},
+        {"cp3_llbb/HHAnalysis/data/Efficiencies/Muon_DoubleIsoMu17TkMu8_IsoMu8legORTkMu8leg.json", &Muon_DoubleIsoMu17TkMu8_IsoMu8legORTkMu8leg, 0x3cfb58859830b34dull},
+        {"cp3_llbb/HHAnalysis/data/Efficiencies/Muon_XPathIsoMu23leg.json", &Muon_XPathIsoMu23leg, 0x08a16fb4048cf5d7ull},
+        {"cp3_llbb/HHAnalysis/data/Efficiencies/Muon_XPathIsoMu8leg.json", &Muon_XPathIsoMu8leg, 0xde7e8eacfaf576e1ull},
+    };
+}
+}
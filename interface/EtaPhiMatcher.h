@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cp3_llbb/HHAnalysis/interface/Types.h>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace HH {
+
+    // Spatial index of a collection of objects (the targets) in the eta-phi plane, to find the targets close to a
+    // given direction without comparing it with every target. The targets are binned in a grid of cells of about
+    // 'cellSize' in eta and phi, phi wrapping around, and only the cells overlapping the cone are looked at.
+    // Distances are compared squared, with the same differences as ROOT::Math::VectorUtil::DeltaR: a target is within
+    // a cone of radius dr exactly when float(DeltaR(p4, target)) < dr.
+    class EtaPhiMatcher {
+        public:
+            explicit EtaPhiMatcher(float cellSize = 0.4);
+
+            void build(const std::vector<LorentzVector>& targets);
+            void build(const std::vector<float>& eta, const std::vector<float>& phi);
+
+            size_t size() const { return m_eta.size(); }
+
+            // Indices of the targets within the cone, in increasing order
+            void withinCone(float eta, float phi, float dr, std::vector<uint32_t>& matches) const;
+            bool anyWithinCone(float eta, float phi, float dr) const;
+            // Index of the closest target within the cone (the first one in case of equal distances), -1 if none
+            int nearest(float eta, float phi, float dr = std::numeric_limits<float>::max()) const;
+
+        private:
+            // Call f(target index, squared distance) for every target within the cone, cell by cell, until f returns false
+            template <typename Function>
+            void visit(float eta, float phi, float dr, Function f) const;
+
+            size_t etaCell(float eta) const;
+            size_t phiCell(float phi) const;
+
+            float m_cellSize;
+            size_t m_n_phi;
+            double m_phi_cell_size;
+            size_t m_n_eta = 0;
+            float m_eta_min = 0;
+            float m_eta_cell_size = 0;
+
+            std::vector<float> m_eta;
+            std::vector<float> m_phi;
+            // Targets sorted by cell: the targets of cell c are m_sorted[m_cell_begin[c]] ... m_sorted[m_cell_begin[c + 1] - 1],
+            // in increasing order. Cell c is (eta cell) * m_n_phi + (phi cell)
+            std::vector<uint32_t> m_cell_begin;
+            std::vector<uint32_t> m_sorted;
+            std::vector<uint32_t> m_cell;
+            // Next free position of each cell in m_sorted, while building
+            std::vector<uint32_t> m_cell_fill;
+    };
+}
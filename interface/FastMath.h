@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Polynomial approximations of the elementary functions used in the kinematic computations.
+// The quoted maximum errors are measured in single precision over the whole float range of the arguments.
+namespace HH {
+namespace fastmath {
+
+    // Accuracy of the kinematic functions: the standard library (Exact), the approximations below (Fast),
+    // or both, keeping the exact result and recording the differences (Validation)
+    enum class Mode {
+        Exact,
+        Fast,
+        Validation
+    };
+
+    Mode modeFromString(const std::string& mode);
+
+    // atan(z) for |z| <= 1 (Abramowitz & Stegun 4.4.49). Max absolute error: 1.2e-5 rad
+    inline float atanUnit(float z) {
+        float z2 = z * z;
+        return z * (0.9998660f + z2 * (-0.3302995f + z2 * (0.1801410f + z2 * (-0.0851330f + z2 * 0.0208351f))));
+    }
+
+    // Max absolute error: 1.2e-5 rad. Same conventions as std::atan2 for the signs and zeros
+    inline float atan2(float y, float x) {
+        float ax = std::abs(x);
+        float ay = std::abs(y);
+        if (ax == 0 && ay == 0)
+            return std::atan2(y, x);
+
+        float a = (ay <= ax) ? atanUnit(ay / ax) : float(M_PI_2) - atanUnit(ax / ay);
+        if (x < 0)
+            a = float(M_PI) - a;
+        return std::copysign(a, y);
+    }
+
+    inline float atan(float z) {
+        return atan2(z, 1.f);
+    }
+
+    // Abramowitz & Stegun 4.4.45, arguments outside [-1, 1] are clamped. Max absolute error: 6.8e-5 rad
+    inline float acos(float x) {
+        float ax = std::min(std::abs(x), 1.f);
+        float a = std::sqrt(1.f - ax) * (1.5707288f + ax * (-0.2121144f + ax * (0.0742610f - ax * 0.0187293f)));
+        return (x < 0) ? float(M_PI) - a : a;
+    }
+
+    // Range reduction on powers of 2 and a degree 6 polynomial. Max relative error: 3e-7.
+    // Falls back to std::exp outside the range of normal floats
+    inline float exp(float x) {
+        if (!(x > -87.f && x < 88.f))
+            return std::exp(x);
+
+        float n = std::nearbyint(x * float(M_LOG2E));
+        // ln(2) split in two parts, so that the reduction is exact
+        float r = (x - n * 0.693145752f) - n * 1.42860677e-6f;
+        float p = 1.f + r * (1.f + r * (0.5f + r * (1.f / 6 + r * (1.f / 24 + r * (1.f / 120 + r * (1.f / 720))))));
+
+        int32_t bits = (int32_t(n) + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        return p * scale;
+    }
+
+    // Taylor series for small arguments, to avoid the cancellation in (e^x - e^-x) / 2. Max relative error: 4e-7
+    inline float sinh(float x) {
+        if (std::abs(x) < 1.f) {
+            float x2 = x * x;
+            return x * (1.f + x2 * (1.f / 6 + x2 * (1.f / 120 + x2 * (1.f / 5040 + x2 * (1.f / 362880)))));
+        }
+        float e = exp(x);
+        return 0.5f * (e - 1.f / e);
+    }
+
+    // Wrap an angle in ]-pi, pi]. The subtraction of 2 pi is exact in double precision for |phi| < 3 pi, which covers
+    // the sum or difference of two azimuthal angles, std::remainder is only used beyond
+    inline float wrapPhi(float phi) {
+        if (std::abs(phi) >= float(3 * M_PI))
+            phi = std::remainder(double(phi), 2 * M_PI);
+        if (phi > float(M_PI))
+            return double(phi) - 2 * M_PI;
+        if (phi <= -float(M_PI))
+            return double(phi) + 2 * M_PI;
+        return phi;
+    }
+
+    // Wrap an angle in ]0, 2 pi], with the same result as std::fmod followed by a translation of the negative values.
+    // The subtractions of 2 pi are exact in double precision for |phi| < 4 pi, std::fmod is only used beyond
+    inline float wrapPhiPositive(float phi) {
+        double p = phi;
+        if (std::abs(p) >= 4 * M_PI)
+            p = std::fmod(p, 2 * M_PI);
+        else if (p >= 2 * M_PI)
+            p -= 2 * M_PI;
+        else if (p <= -2 * M_PI)
+            p += 2 * M_PI;
+        float result = p;
+        return (result > 0) ? result : float(2 * M_PI + result);
+    }
+
+    // Distribution of the absolute differences between the fast and the exact implementations of a function,
+    // in bins of one decade from 1e-9 to 1e-1, plus an underflow and an overflow bin
+    class Validation {
+        public:
+            static constexpr size_t n_bins = 10;
+
+            void fill(double exact, double fast);
+
+            std::array<unsigned long, n_bins> counts = {};
+            unsigned long entries = 0;
+            // Entries where only one of the results is a NaN or an infinity, not in counts
+            unsigned long mismatches = 0;
+            double max_difference = 0;
+            // Exact value for which the largest difference is found
+            double max_difference_exact = 0;
+
+            // Label of bin i, e.g. "1e-6" for [1e-6, 1e-5[
+            static std::string binLabel(size_t i);
+    };
+}
+}
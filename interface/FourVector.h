@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cp3_llbb/HHAnalysis/interface/Types.h>
+
+namespace HH {
+
+    // Four-vector for the analyzer internals, holding both the polar (pt, eta, phi) and the cartesian (px, py, pz) components.
+    // Each representation is computed lazily, at most once, with the same formulas as HH::LorentzVector, and sums are done
+    // on the cartesian components without going through the polar ones. Convert with p4() when filling the output structures.
+    class FourVector {
+        public:
+            FourVector() = default;
+
+            FourVector(const LorentzVector& p4):
+                m_pt(p4.Pt()), m_eta(p4.Eta()), m_phi(p4.Phi()), m_E(p4.E()), m_hasCartesian(false) {}
+
+            FourVector(float pt, float eta, float phi, float E, float px, float py, float pz):
+                m_pt(pt), m_eta(eta), m_phi(phi), m_E(E), m_px(px), m_py(py), m_pz(pz) {}
+
+            static FourVector fromCartesian(float px, float py, float pz, float E) {
+                FourVector v;
+                v.m_px = px;
+                v.m_py = py;
+                v.m_pz = pz;
+                v.m_E = E;
+                v.m_hasPolar = false;
+                return v;
+            }
+
+            float Pt() const { computePolar(); return m_pt; }
+            float Eta() const { computePolar(); return m_eta; }
+            float Phi() const { computePolar(); return m_phi; }
+            float E() const { return m_E; }
+            float Px() const { computeCartesian(); return m_px; }
+            float Py() const { computeCartesian(); return m_py; }
+            float Pz() const { computeCartesian(); return m_pz; }
+
+            FourVector operator+(const FourVector& other) const {
+                return fromCartesian(Px() + other.Px(), Py() + other.Py(), Pz() + other.Pz(), E() + other.E());
+            }
+
+            FourVector& operator+=(const FourVector& other) {
+                *this = *this + other;
+                return *this;
+            }
+
+            LorentzVector p4() const {
+                computePolar();
+                return LorentzVector(m_pt, m_eta, m_phi, m_E);
+            }
+
+        private:
+            void computeCartesian() const {
+                if (m_hasCartesian)
+                    return;
+
+                LorentzVector p4(m_pt, m_eta, m_phi, m_E);
+                m_px = p4.Px();
+                m_py = p4.Py();
+                m_pz = p4.Pz();
+                m_hasCartesian = true;
+            }
+
+            void computePolar() const {
+                if (m_hasPolar)
+                    return;
+
+                LorentzVector p4;
+                p4.SetPxPyPzE(m_px, m_py, m_pz, m_E);
+                m_pt = p4.Pt();
+                m_eta = p4.Eta();
+                m_phi = p4.Phi();
+                m_hasPolar = true;
+            }
+
+            mutable float m_pt = 0.;
+            mutable float m_eta = 0.;
+            mutable float m_phi = 0.;
+            float m_E = 0.;
+            mutable float m_px = 0.;
+            mutable float m_py = 0.;
+            mutable float m_pz = 0.;
+            mutable bool m_hasPolar = true;
+            mutable bool m_hasCartesian = true;
+    };
+}
@@ -7,12 +7,29 @@
 #include <cp3_llbb/Framework/interface/WeightedBinnedValues.h>
 
 #include <cp3_llbb/HHAnalysis/interface/Types.h>
-#include <cp3_llbb/HHAnalysis/interface/lester_mt2_bisect.h>
+#include <cp3_llbb/HHAnalysis/interface/PairKinematics.h>
+#include <cp3_llbb/HHAnalysis/interface/FastMath.h>
+#include <cp3_llbb/HHAnalysis/interface/MELAKinematics.h>
+#include <cp3_llbb/HHAnalysis/interface/MT2Engine.h>
+#include <cp3_llbb/HHAnalysis/interface/Preselection.h>
+#include <cp3_llbb/HHAnalysis/interface/CutExpression.h>
+#include <cp3_llbb/HHAnalysis/interface/EtaPhiMatcher.h>
+#include <cp3_llbb/HHAnalysis/interface/CompiledBinnedValues.h>
+#include <cp3_llbb/HHAnalysis/interface/DileptonChannel.h>
+#include <cp3_llbb/HHAnalysis/interface/HLTObjectFlags.h>
 #include <cp3_llbb/Framework/interface/HLTProducer.h>
+#include <cp3_llbb/Framework/interface/JetsProducer.h>
+#include <cp3_llbb/Framework/interface/ElectronsProducer.h>
+#include <cp3_llbb/Framework/interface/MuonsProducer.h>
+#include <cp3_llbb/Framework/interface/GenParticlesProducer.h>
+#include <cp3_llbb/Framework/interface/EventProducer.h>
 
 #include <Math/VectorUtil.h>
 
+#include <algorithm>
+#include <map>
 #include <random>
+#include <stdexcept>
 
 using namespace HH;
 using namespace HHAnalysis;
@@ -51,35 +68,152 @@ class HHAnalyzer: public Framework::Analyzer {
             m_jet_bDiscrCut_tight = config.getUntrackedParameter<double>("discr_cut_tight");
             m_minDR_l_j_Cut = config.getUntrackedParameter<double>("minDR_l_j_Cut", 0.3);
             m_applyBJetRegression = config.getUntrackedParameter<bool>("applyBJetRegression", false);
+            // Run the reco dilepton selection first, and fill the MC truth only for events with a selected dilepton
+            m_genTruthAfterRecoSelection = config.getUntrackedParameter<bool>("genTruthAfterRecoSelection", false);
+            // Additional cuts on the selected leptons, jets and llmetjj candidates (see interface/CutExpression.h for the syntax)
+            m_leptonCut = HH::CutExpression<HH::Lepton>(config.getUntrackedParameter<std::string>("leptonCut", ""), HH::leptonCutVariables());
+            m_jetCut = HH::CutExpression<HH::Jet>(config.getUntrackedParameter<std::string>("jetCut", ""), HH::jetCutVariables());
+            m_llmetjjCut = HH::CutExpression<HH::DileptonMetDijet>(config.getUntrackedParameter<std::string>("llmetjjCut", ""), HH::dileptonMetDijetCutVariables());
+            // Build every jet pair in the jj collection (for studies) instead of only the best one
+            m_enumerateAllDijets = config.getUntrackedParameter<bool>("enumerateAllDijets", false);
+            // Jet pair orderings for which the best pair is stored in the bestJetPairs branch
+            for (const std::string& strategy: config.getUntrackedParameter<std::vector<std::string>>("jetPairStrategies", std::vector<std::string>())) {
+                auto it = std::find_if(jetPair::map.begin(), jetPair::map.end(), [&strategy](const std::pair<const jetPair::jetPair, std::string>& p) { return p.second == strategy; });
+                if (it == jetPair::map.end())
+                    throw std::invalid_argument("Unknown jet pair strategy: " + strategy);
+                m_jetPairStrategies.push_back(it->first);
+            }
+            // The jet probability discriminant is only read for the jp ordering, it may not be stored otherwise
+            m_fillJetProbability = std::find(m_jetPairStrategies.begin(), m_jetPairStrategies.end(), jetPair::jp) != m_jetPairStrategies.end();
+            // Budget on the number of jets entering the pairing (0: no limit), keeping the best ones according to jetPairingRanking
+            m_maxJetsForPairing = config.getUntrackedParameter<unsigned int>("maxJetsForPairing", 0);
+            const std::string jetPairingRanking = config.getUntrackedParameter<std::string>("jetPairingRanking", "CMVAv2");
+            if (jetPairingRanking != "CMVAv2" && jetPairingRanking != "pt")
+                throw std::invalid_argument("Unknown jet pairing ranking: " + jetPairingRanking);
+            m_rankJetsForPairingByPt = (jetPairingRanking == "pt");
+            // Accuracy of the angular functions in plugins/Tools.cc: "exact", "fast" (see interface/FastMath.h),
+            // or "validation" (exact results, with the differences to the fast ones stored in the metadata)
+            m_mathMode = HH::fastmath::modeFromString(config.getUntrackedParameter<std::string>("kinematicsMathMode", "exact"));
 
             m_hltDRCut = config.getUntrackedParameter<double>("hltDRCut", std::numeric_limits<float>::max());
             m_hltDPtCut = config.getUntrackedParameter<double>("hltDPtCut", std::numeric_limits<float>::max());
+            // Filters of the legs of the same-flavour dilepton paths
+            m_hlt_leg_filters[MuMuChannel::leg1] = hlt_flags.filterMask(MuMuChannel::leg1Filters());
+            m_hlt_leg_filters[MuMuChannel::leg2] = hlt_flags.filterMask(MuMuChannel::leg2Filters());
+            m_hlt_leg_filters[ElElChannel::leg1] = hlt_flags.filterMask(ElElChannel::leg1Filters());
+            m_hlt_leg_filters[ElElChannel::leg2] = hlt_flags.filterMask(ElElChannel::leg2Filters());
+
+            // Use the tables compiled from the JSON files (see scripts/generateEfficiencyTables.py) instead of parsing them. Their
+            // lookups do not allocate, unlike BinnedValues::get, which is only used for the files without a compiled table
+            const bool useCompiledEfficiencyTables = config.getUntrackedParameter<bool>("useCompiledEfficiencyTables", true);
+            // Merge the parts of the weighted efficiencies into a single table, when they all have a compiled table
+            const bool mergeWeightedEfficiencies = config.getUntrackedParameter<bool>("mergeWeightedEfficiencies", true);
+            std::unordered_map<std::string, const HH::CompiledBinnedValues*> hlt_compiled_efficiencies;
 
             const edm::ParameterSet& hlt_efficiencies = config.getUntrackedParameter<edm::ParameterSet>("hlt_efficiencies");
             std::vector<std::string> hlt_efficiencies_name = hlt_efficiencies.getParameterNames();
             for (const std::string& hlt_efficiency: hlt_efficiencies_name) {
                 std::cout << "    Registering new HLT efficiency: " << hlt_efficiency;
-                if (hlt_efficiencies.existsAs<edm::FileInPath>(hlt_efficiency, false)) {
+                const HH::CompiledBinnedValues* compiled = nullptr;
+                if (useCompiledEfficiencyTables && hlt_efficiencies.existsAs<edm::FileInPath>(hlt_efficiency, false)) {
+                    const edm::FileInPath& file = hlt_efficiencies.getUntrackedParameter<edm::FileInPath>(hlt_efficiency);
+                    compiled = HH::findCompiledBinnedValues(file.relativePath(), file.fullPath());
+                }
+                if (compiled) {
+                    hlt_compiled_efficiencies.emplace(hlt_efficiency, compiled);
+                    std::cout << " -> compiled. " << std::endl;
+                } else if (hlt_efficiencies.existsAs<edm::FileInPath>(hlt_efficiency, false)) {
                     BinnedValuesJSONParser parser(hlt_efficiencies.getUntrackedParameter<edm::FileInPath>(hlt_efficiency).fullPath());
                     m_hlt_efficiencies.emplace(hlt_efficiency, std::unique_ptr<BinnedValues>(new BinnedValues(std::move(parser.get_values()))));
                     std::cout << " -> non-weighted. " << std::endl;
                 } else {
                     const auto& parts = hlt_efficiencies.getUntrackedParameter<std::vector<edm::ParameterSet>>(hlt_efficiency);
-                    m_hlt_efficiencies.emplace(hlt_efficiency, std::unique_ptr<BinnedValues>(new WeightedBinnedValues(parts)));
-                    std::cout << " -> weighted. " << std::endl;
+                    std::vector<std::pair<const HH::CompiledBinnedValues*, double>> compiled_parts;
+                    if (mergeWeightedEfficiencies) {
+                        for (const auto& part: parts) {
+                            const edm::FileInPath& file = part.getUntrackedParameter<edm::FileInPath>("file");
+                            const HH::CompiledBinnedValues* table = HH::findCompiledBinnedValues(file.relativePath(), file.fullPath());
+                            if (!table) {
+                                compiled_parts.clear();
+                                break;
+                            }
+                            compiled_parts.emplace_back(table, part.getUntrackedParameter<double>("weight"));
+                        }
+                    }
+                    if (!compiled_parts.empty()) {
+                        m_hlt_merged_efficiencies.emplace_back(new HH::MergedBinnedValues(compiled_parts));
+                        hlt_compiled_efficiencies.emplace(hlt_efficiency, &m_hlt_merged_efficiencies.back()->table());
+                        std::cout << " -> weighted, merged. " << std::endl;
+                    } else {
+                        m_hlt_efficiencies.emplace(hlt_efficiency, std::unique_ptr<BinnedValues>(new WeightedBinnedValues(parts)));
+                        std::cout << " -> weighted. " << std::endl;
+                    }
                 }
             }
-
-            asymm_mt2_lester_bisect::disableCopyrightMessage();
+            // Tables of the trigger legs, resolved once. A missing one is only an error when a pair of its channel is
+            // evaluated (never on data), see fillTriggerLegEfficiencies
+            for (const triggerLeg::triggerLeg& leg: triggerLeg::it) {
+                auto compiled = hlt_compiled_efficiencies.find(triggerLeg::map.at(leg));
+                m_hlt_compiled_legs[leg] = (compiled == hlt_compiled_efficiencies.end()) ? nullptr : compiled->second;
+                auto it = m_hlt_efficiencies.find(triggerLeg::map.at(leg));
+                m_hlt_legs[leg] = (it == m_hlt_efficiencies.end()) ? nullptr : it->second.get();
+            }
+            // Absolute precision on MT2, and MT2 cut for which the computation stops as soon as the side of the cut is known (0: disabled)
+            m_mt2Engine = HH::MT2Engine(config.getUntrackedParameter<double>("mt2Precision", 0.5), config.getUntrackedParameter<double>("mt2Threshold", 0));
         }
         virtual void endJob(MetadataManager&) override;
 
         BRANCH(leptons, std::vector<HH::Lepton>);
         BRANCH(met, std::vector<HH::Met>);
         BRANCH(jets, std::vector<HH::Jet>);
+        // Per-event working buffers below are members, cleared at each event: their capacity is kept from one event
+        // to the next, so that the steady state does not allocate
+        // Indices of the positive and negative leptons, for the opposite-sign pairing
+        std::vector<unsigned int> positive_leptons;
+        std::vector<unsigned int> negative_leptons;
+        std::vector<HH::DileptonCandidate> ll_candidates;
         std::vector<HH::Dilepton> ll;
-        std::vector<HH::DileptonMet> llmet;
+        std::vector<HH::DileptonMetCandidate> llmet;
         std::vector<HH::Dijet> jj;
+        // Indices of the jets entering the pairing, in increasing order
+        std::vector<unsigned int> pairing_jets;
+        // Preselection of the producer objects, and b-jet regression factor of each jet of the producer
+        HH::Preselection preselection;
+        std::vector<float> jet_correction_factors;
+        // Inputs and results of the MELA angles computation for the llmetjj candidates
+        std::vector<HH::MELAInputs> mela_inputs;
+        std::vector<HH::MELAResults> mela_results;
+        std::vector<HH::MT2Input> mt2_inputs;
+        std::vector<HH::MT2Result> mt2_results;
+        // Position of each jet in pairing_jets, -1 if it does not enter the pairing
+        std::vector<int> pairing_position;
+        // (index, regression factor) of the jets passing the kinematic and ID cuts, before the jet-lepton cleaning
+        std::vector<std::pair<unsigned int, float>> jet_candidates;
+
+        // Pairwise kinematics, computed once per event for all the pairs (see interface/PairKinematics.h)
+        HH::KinematicsSoA leptons_soa;
+        HH::KinematicsSoA jets_soa;
+        HH::KinematicsSoA pairing_jets_soa;
+        HH::PairMatrix ll_DPhi, ll_DR; // leptons x leptons
+        HH::PairMatrix jl_DPhi, jl_DR; // jets x leptons
+        // Eta-phi grids of the selected leptons (jet-lepton cleaning) and of the HLT objects (HLT matching)
+        HH::EtaPhiMatcher lepton_matcher;
+        HH::EtaPhiMatcher hlt_matcher;
+        std::vector<uint32_t> hlt_matches;
+        // Paths and filters of the HLT objects, and HLT objects preselected for each lepton (see matchOfflineLepton)
+        HH::HLTObjectFlags hlt_flags;
+        std::vector<std::vector<int8_t>> hlt_lepton_objects;
+        std::vector<bool> hlt_lepton_objects_cached;
+        std::pair<std::vector<int8_t>, std::vector<int8_t>> hlt_samepath_indices;
+        HH::PairMatrix jj_DPhi, jj_DR; // pairing jets x pairing jets
+        HH::PairMatrix jj_M, jj_Pt; // pairing jets x pairing jets, only filled when needed by the bestJetPairs orderings
+        std::vector<HH::DileptonMetDijetCandidate> llmetjj_candidates;
+
+        // Constituents of the in-memory composite candidates
+        const HH::Dilepton& getDilepton(const HH::DileptonMetCandidate& candidate) const { return ll[candidate.ill]; }
+        const HH::Met& getMet(const HH::DileptonMetCandidate& candidate) const { return met[candidate.imet]; }
+        const HH::DileptonMetCandidate& getDileptonMet(const HH::DileptonMetDijetCandidate& candidate) const { return llmet[candidate.illmet]; }
+        const HH::Dijet& getDijet(const HH::DileptonMetDijetCandidate& candidate) const { return jj[candidate.ijj]; }
 
         //std::vector<HH::DileptonMetDijet> llmetjj;
         //std::vector<HH::DileptonMetDijet> llmetjj_cmva;
@@ -94,23 +228,87 @@ class HHAnalyzer: public Framework::Analyzer {
         //BRANCH(llmetjj_HWWleptons_btagMT_cmva, std::vector<HH::DileptonMetDijet>);
 
         BRANCH(llmetjj, std::vector<HH::DileptonMetDijet>);
+        // (ijet1, ijet2) of the best jet pair for each jetPair ordering, indexed by HHAnalysis::jetPair
+        // (-1, -1) if the ordering is not configured or if there are less than two jets
+        BRANCH(bestJetPairs, std::vector<std::pair<int8_t, int8_t>>);
+        // True if some jets were left out of the pairing because of maxJetsForPairing
+        BRANCH(jetPairingTruncated, bool);
 
         virtual void analyze(const edm::Event&, const edm::EventSetup&, const ProducersManager&, const AnalyzersManager&, const CategoryManager&) override;
         virtual void registerCategories(CategoryManager& manager, const edm::ParameterSet& config) override;
 
         // Various helper functions, implemented in plugins/Tools.cc
         float getCosThetaStar_CS(const LorentzVector & h1, const LorentzVector & h2, float ebeam = 6500);
-        MELAAngles getMELAAngles(const LorentzVector &q1, const LorentzVector &q2, const LorentzVector &q11, const LorentzVector &q12, const LorentzVector &q21, const LorentzVector &q22, float ebeam = 6500);
         void matchOfflineLepton(const HLTProducer& hlt, Dilepton& dilepton);
-        void fillTriggerEfficiencies(const Lepton & lep1, const Lepton & lep2, Dilepton & dilep);
+        template <typename Channel> void matchOfflineLepton(const HLTProducer& hlt, Dilepton& dilepton);
+        // Trigger leg efficiencies are evaluated once per lepton and channel type, and cached in the lepton
+        // Efficiency and errors of a trigger leg
+        HH::EfficiencyValue getTriggerLegEfficiency(triggerLeg::triggerLeg leg, float eta, float pt);
+        template <typename Channel, typename Flavour> void fillTriggerLegEfficiencies(Lepton & lep);
+        void fillTriggerEfficiencies(Lepton & lep1, Lepton & lep2, Dilepton & dilep);
+        template <typename Channel> void fillTriggerEfficiencies(Lepton & lep1, Lepton & lep2, Dilepton & dilep);
+        // Build the full llmetjj candidate out of the ll, met and jj collections, implemented in plugins/HHAnalyzer.cc
+        HH::Dilepton makeDilepton(unsigned int ilep1, unsigned int ilep2);
+        HH::Dijet makeDijet(unsigned int ijet1, unsigned int ijet2);
+        HH::DileptonMetDijet makeDileptonMetDijet(unsigned int illmet, unsigned int ijj);
+        HH::MELAInputs makeMELAInputs(unsigned int illmet, unsigned int ijet1, unsigned int ijet2);
+        HH::MT2Input makeMT2Input(unsigned int illmet, unsigned int ijet1, unsigned int ijet2);
+        // Returns false if a pair could not be stored, its jet indices not fitting in the branch
+        bool fillBestJetPairs();
+        // MC truth, implemented in plugins/HHAnalyzer.cc. passTauBRReweighting returns false if the event must be thrown away
+        bool passTauBRReweighting(const EventProducer& fwevent, const GenParticlesProducer& gp);
+        void fillHHGenInfo(const GenParticlesProducer& gp, const JetsProducer& alljets, const ElectronsProducer& allelectrons, const MuonsProducer& allmuons);
+        void fillTTGenInfo(const GenParticlesProducer& gen_particles);
+        // Single pass over the pairing jets returning the indices (ijet1 < ijet2) of the two jets with the highest key,
+        // ie. the best dijet for any ranking variable which is a sum of per-jet quantities. (-1, -1) if there are less than two jets.
+        template <typename KeyFunction>
+        std::pair<int, int> findBestJetPair(KeyFunction key) {
+            int ibest = -1, isecond = -1;
+            float best_key = 0., second_key = 0.;
+            for (unsigned int ijet: pairing_jets) {
+                float jet_key = key(jets[ijet]);
+                if (ibest == -1 || jet_key > best_key) {
+                    isecond = ibest;
+                    second_key = best_key;
+                    ibest = ijet;
+                    best_key = jet_key;
+                } else if (isecond == -1 || jet_key > second_key) {
+                    isecond = ijet;
+                    second_key = jet_key;
+                }
+            }
+            if (isecond == -1)
+                return std::make_pair(-1, -1);
+            return std::make_pair(std::min(ibest, isecond), std::max(ibest, isecond));
+        }
         
+        // Evaluate a kinematic function with the exact or the fast implementation, according to kinematicsMathMode.
+        // In validation mode, both are evaluated and the exact result is returned
+        template <typename ExactFunction, typename FastFunction>
+        float evaluateKinematics(const char* name, ExactFunction exact, FastFunction fast) {
+            switch (m_mathMode) {
+                case HH::fastmath::Mode::Fast:
+                    return fast();
+                case HH::fastmath::Mode::Validation: {
+                    float exact_value = exact();
+                    m_mathValidation[name].fill(exact_value, fast());
+                    return exact_value;
+                }
+                default:
+                    return exact();
+            }
+        }
+
         // Stuff for L1 EMTF muon mitigation
         float getL1TPhi(int charge, const LorentzVector& p);
-        bool sameEndCap(const LorentzVector& p1, const LorentzVector& p2);
+        // +1 (-1) in the positive (negative) endcap, |eta| > 1.24, 0 otherwise
+        int8_t getCSCEndCap(const LorentzVector& p);
         // Translate phi by 'translation', and put it into [0, 2pi[
         float translatePhi(float phi, float translation=0);
         // Get N s.t. start + 60° * N <= phi < end + 60° + N; return -1 if no such N
         int getPhiSector(float phi, float start, float end);
+        // Fill the L1T phi, endcap, sector and overlap of a muon, used by the two functions below
+        void fillL1TGeometry(Lepton& mu);
         // See https://twiki.cern.ch/twiki/bin/view/CMS/EndcapHighPtMuonEfficiencyProblem:
         // Case 2) -- using gen info (to apply weights on MC)
         bool isCSCSameSector(const Lepton& lep1, const Lepton& lep2);
@@ -139,6 +337,15 @@ class HHAnalyzer: public Framework::Analyzer {
         float count_has2leptons_elmu_1llmetjj_2btagM = 0.;
         float count_has2leptons_muel_1llmetjj_2btagM = 0.;
         float count_has2leptons_mumu_1llmetjj_2btagM = 0.;
+        // Unweighted number of events with a truncated jet pairing, and of jets left out. Integers, as a float stops
+        // counting exactly at 2^24; converted in endJob
+        uint64_t count_jetPairingTruncated = 0;
+        uint64_t count_jetPairingDroppedJets = 0;
+        // Number of events with a bestJetPairs pair stored as (-1, -1), its jet indices not fitting in an int8_t
+        uint64_t count_bestJetPairsOverflow = 0;
+        // Number of MT2 computations, and of ellipse tests done for them
+        uint64_t count_mt2Evaluations = 0;
+        uint64_t count_mt2Iterations = 0;
 
         // ttbar system mc truth
         // Gen matching. All indexes are from the `pruned` collection
@@ -247,13 +454,32 @@ class HHAnalyzer: public Framework::Analyzer {
         float m_jetEtaCut, m_jetPtCut, m_jet_bDiscrCut_loose, m_jet_bDiscrCut_medium, m_jet_bDiscrCut_tight;
         float m_minDR_l_j_Cut;
         float m_hltDRCut, m_hltDPtCut;
+        std::array<uint64_t, triggerLeg::Count> m_hlt_leg_filters = {};
         std::string m_jet_bDiscrName;
         std::string m_electron_loose_wp_name;
         std::string m_electron_medium_wp_name;
         std::string m_electron_tight_wp_name;
         std::string m_electron_hlt_safe_wp_name;
         bool m_applyBJetRegression;
+        bool m_enumerateAllDijets;
+        bool m_genTruthAfterRecoSelection;
+        HH::CutExpression<HH::Lepton> m_leptonCut;
+        HH::CutExpression<HH::Jet> m_jetCut;
+        HH::CutExpression<HH::DileptonMetDijet> m_llmetjjCut;
+        std::vector<jetPair::jetPair> m_jetPairStrategies;
+        bool m_fillJetProbability;
+        unsigned int m_maxJetsForPairing;
+        bool m_rankJetsForPairingByPt;
+        HH::fastmath::Mode m_mathMode;
+        std::map<std::string, HH::fastmath::Validation> m_mathValidation;
+        HH::MT2Engine m_mt2Engine;
         std::unordered_map<std::string, std::unique_ptr<BinnedValues>> m_hlt_efficiencies;
+        std::array<const BinnedValues*, triggerLeg::Count> m_hlt_legs;
+        // Compiled tables of the trigger legs, used first when set
+        std::array<const HH::CompiledBinnedValues*, triggerLeg::Count> m_hlt_compiled_legs;
+        std::vector<std::unique_ptr<HH::MergedBinnedValues>> m_hlt_merged_efficiencies;
+        // Binning parameters of the trigger leg lookups, reused from one lepton to the next
+        Parameters hlt_parameters = {{BinningVariable::Eta, 0.}, {BinningVariable::Pt, 0.}};
 
         std::mt19937 random_generator;
         std::uniform_real_distribution<double> br_generator;
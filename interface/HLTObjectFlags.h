@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace HH {
+
+    // HLT paths and filters of the HLT objects of an event as integers, to compare them without comparing strings:
+    // the objects sharing a path are found by intersecting sorted path IDs, and the objects passing a list of filters
+    // with a mask. The names are interned to integer IDs, kept from one event to the next, so that each name of a HLT
+    // menu is given an ID only once. The IDs of an object are only looked up the first time it is queried in the event:
+    // only the few objects matched to a lepton are.
+    class HLTObjectFlags {
+        public:
+            // Mask of a list of filters, registering the ones not known yet. At most 64 filters can be registered,
+            // the other filters of the HLT objects are ignored
+            uint64_t filterMask(const std::vector<std::string>& filters);
+
+            // New event. The collections must outlive the queries of the event
+            void build(const std::vector<std::vector<std::string>>& object_paths, const std::vector<std::vector<std::string>>& object_filters);
+
+            bool sharePath(size_t i, size_t j) {
+                const std::vector<uint32_t>& paths_i = paths(i);
+                const std::vector<uint32_t>& paths_j = paths(j);
+                auto it_i = paths_i.begin();
+                auto it_j = paths_j.begin();
+                while (it_i != paths_i.end() && it_j != paths_j.end()) {
+                    if (*it_i < *it_j)
+                        ++it_i;
+                    else if (*it_j < *it_i)
+                        ++it_j;
+                    else
+                        return true;
+                }
+                return false;
+            }
+
+            // Whether object i passed one of the filters of the mask
+            bool passFilters(size_t i, uint64_t mask) { return filters(i) & mask; }
+
+        private:
+            const std::vector<uint32_t>& paths(size_t i);
+            uint64_t filters(size_t i);
+
+            std::unordered_map<std::string, uint32_t> m_path_ids;
+            std::unordered_map<std::string, uint64_t> m_filter_bits;
+
+            const std::vector<std::vector<std::string>>* m_object_paths = nullptr;
+            const std::vector<std::vector<std::string>>* m_object_filters = nullptr;
+
+            // Sorted path IDs and filter bits of the objects queried in the event. The buffers are reused from one
+            // event to the next
+            enum Cached: uint8_t { Paths = 1, Filters = 2 };
+            std::vector<uint8_t> m_cached;
+            std::vector<std::vector<uint32_t>> m_paths;
+            std::vector<uint64_t> m_filters;
+    };
+}
@@ -51,6 +51,15 @@ namespace HHAnalysis {
     const std::map<jetPair, std::string> map = { {ht, "ht"}, {mh, "mh"}, {pt, "pt"}, {csv, "csv"}, {jp, "jp"}, {ptOverM, "ptOverM"} }; 
   }
 
+  // Legs of the dilepton triggers, for the HLT efficiencies
+  namespace triggerLeg {
+    enum triggerLeg { IsoMu17, IsoMu8orIsoTkMu8, IsoMu23, IsoMu8, DoubleEleHighPt, DoubleEleLowPt, EleMuHighPt, MuEleLowPt, Count };
+    const std::array<triggerLeg, Count> it = {{ IsoMu17, IsoMu8orIsoTkMu8, IsoMu23, IsoMu8, DoubleEleHighPt, DoubleEleLowPt, EleMuHighPt, MuEleLowPt }};
+    // Name of the efficiency in the hlt_efficiencies parameter set
+    const std::map<triggerLeg, std::string> map = { {IsoMu17, "IsoMu17leg"}, {IsoMu8orIsoTkMu8, "IsoMu8orIsoTkMu8leg"}, {IsoMu23, "IsoMu23leg"}, {IsoMu8, "IsoMu8leg"},
+      {DoubleEleHighPt, "DoubleEleHighPtleg"}, {DoubleEleLowPt, "DoubleEleLowPtleg"}, {EleMuHighPt, "EleMuHighPtleg"}, {MuEleLowPt, "MuEleLowPtleg"} };
+  }
+
   // Combination of jet ID and B-tagging working point for one jet
   uint16_t jetIDbtagWP(const jetID::jetID& id, const btagWP::btagWP& wp);
   std::string jetIDbtagWPStr(const jetID::jetID& id, const btagWP::btagWP& wp);
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cp3_llbb/HHAnalysis/interface/Types.h>
+
+// Persistent layouts of the previous releases, to read their files. They are registered in src/classes_def.xml with rules
+// renaming the on-file classes into them: bind the branch of an old file to a std::vector<HH::legacy::DileptonMetDijet>
+// and convert each entry with toFlat().
+namespace HH {
+namespace legacy {
+
+    // HH::DileptonMet up to version 12
+    struct DileptonMet : public Dilepton, public Met {
+        LorentzVector p4;
+        LorentzVector gen_p4;
+        int ill; // index in the HH::Dilepton collection
+        int imet; // index in the HH::Met collection
+        float DPhi_ll_met;
+        float minDPhi_l_met;
+        float maxDPhi_l_met;
+        float MT;
+        float MT_formula;
+        float projectedMet;
+        bool gen_matched;
+        float gen_DR;
+        float gen_DPhi;
+        float gen_DPtOverPt;
+    };
+
+    // HH::DileptonMetDijet up to version 12, with the dilepton, met and dijet quantities in the base-class sub-objects
+    struct DileptonMetDijet : public DileptonMet, public Dijet {
+        LorentzVector p4;
+        LorentzVector lep1_p4;
+        LorentzVector lep2_p4;
+        LorentzVector jet1_p4;
+        LorentzVector jet2_p4;
+        LorentzVector met_p4;
+        LorentzVector ll_p4;
+        LorentzVector jj_p4;
+        LorentzVector lljj_p4;
+
+        LorentzVector gen_p4;
+        LorentzVector gen_lep1_p4;
+        LorentzVector gen_lep2_p4;
+        LorentzVector gen_jet1_p4;
+        LorentzVector gen_jet2_p4;
+        LorentzVector gen_met_p4;
+        LorentzVector gen_ll_p4;
+        LorentzVector gen_jj_p4;
+        LorentzVector gen_lljj_p4;
+        float DPhi_jj_met;
+        float minDPhi_j_met;
+        float maxDPhi_j_met;
+        float maxDR_l_j;
+        float minDR_l_j;
+        float DR_ll_jj;
+        float DPhi_ll_jj;
+        float DR_llmet_jj;
+        float DPhi_llmet_jj;
+        float cosThetaStar_CS;
+        float MT_fullsystem;
+        bool gen_matched;
+        float gen_DR;
+        float gen_DPhi;
+        float gen_DPtOverPt;
+        MELAAngles melaAngles;
+        MELAAngles visMelaAngles;
+        float MT2;
+
+        // Same candidate in the current flat layout
+        HH::DileptonMetDijet toFlat() const {
+            const Dilepton& ll = *this;
+            const Met& met = *this;
+            const DileptonMet& llmet = *this;
+            const Dijet& jj = *this;
+
+            HH::DileptonMetDijet flat;
+            flat.p4 = p4;
+            flat.lep1_p4 = lep1_p4;
+            flat.lep2_p4 = lep2_p4;
+            flat.jet1_p4 = jet1_p4;
+            flat.jet2_p4 = jet2_p4;
+            // Transient in version 12 as well
+            flat.met_p4 = p4 - ll_p4 - jj_p4;
+            flat.ll_p4 = ll_p4;
+            flat.jj_p4 = jj_p4;
+
+            flat.gen_p4 = gen_p4;
+            flat.gen_lep1_p4 = gen_lep1_p4;
+            flat.gen_lep2_p4 = gen_lep2_p4;
+            flat.gen_jet1_p4 = gen_jet1_p4;
+            flat.gen_jet2_p4 = gen_jet2_p4;
+            flat.gen_met_p4 = gen_met_p4;
+            flat.gen_ll_p4 = gen_ll_p4;
+            flat.gen_jj_p4 = gen_jj_p4;
+
+            // dilepton
+            flat.ilep1 = ll.ilep1;
+            flat.ilep2 = ll.ilep2;
+            flat.isOS = ll.isOS;
+            flat.isPlusMinus = ll.isPlusMinus;
+            flat.isMinusPlus = ll.isMinusPlus;
+            flat.isMuMu = ll.isMuMu;
+            flat.isElEl = ll.isElEl;
+            flat.isElMu = ll.isElMu;
+            flat.isMuEl = ll.isMuEl;
+            flat.isSF = ll.isSF;
+            flat.DR_l_l = ll.DR_l_l;
+            flat.DPhi_l_l = ll.DPhi_l_l;
+            flat.ht_l_l = ll.ht_l_l;
+            flat.trigger_efficiency = ll.trigger_efficiency;
+            flat.trigger_efficiency_downVariated = ll.trigger_efficiency_downVariated;
+            flat.trigger_efficiency_upVariated = ll.trigger_efficiency_upVariated;
+
+            // met
+            flat.imet = llmet.imet;
+            flat.isNoHF = met.isNoHF;
+
+            // dilepton + met
+            flat.DPhi_ll_met = llmet.DPhi_ll_met;
+            flat.minDPhi_l_met = llmet.minDPhi_l_met;
+            flat.maxDPhi_l_met = llmet.maxDPhi_l_met;
+            flat.MT = llmet.MT;
+            flat.MT_formula = llmet.MT_formula;
+            flat.projectedMet = llmet.projectedMet;
+
+            // dijet
+            flat.ijet1 = jj.ijet1;
+            flat.ijet2 = jj.ijet2;
+            flat.btag_MM = jj.btag_MM;
+            flat.sumCSV = jj.sumCSV;
+            flat.sumCMVAv2 = jj.sumCMVAv2;
+            flat.DR_j_j = jj.DR_j_j;
+            flat.DPhi_j_j = jj.DPhi_j_j;
+            flat.ht_j_j = jj.ht_j_j;
+            flat.gen_matched_bbPartons = jj.gen_matched_bbPartons;
+            flat.gen_matched_bbHadrons = jj.gen_matched_bbHadrons;
+            flat.gen_bb = jj.gen_bb;
+            flat.gen_bc = jj.gen_bc;
+            flat.gen_bl = jj.gen_bl;
+            flat.gen_cc = jj.gen_cc;
+            flat.gen_cl = jj.gen_cl;
+            flat.gen_ll = jj.gen_ll;
+
+            // dilepton + met + dijet
+            flat.DPhi_jj_met = DPhi_jj_met;
+            flat.minDPhi_j_met = minDPhi_j_met;
+            flat.maxDPhi_j_met = maxDPhi_j_met;
+            flat.maxDR_l_j = maxDR_l_j;
+            flat.minDR_l_j = minDR_l_j;
+            flat.DR_ll_jj = DR_ll_jj;
+            flat.DPhi_ll_jj = DPhi_ll_jj;
+            flat.DR_llmet_jj = DR_llmet_jj;
+            flat.DPhi_llmet_jj = DPhi_llmet_jj;
+            flat.cosThetaStar_CS = cosThetaStar_CS;
+            flat.MT_fullsystem = MT_fullsystem;
+            flat.gen_matched = gen_matched;
+            flat.gen_DR = gen_DR;
+            flat.gen_DPhi = gen_DPhi;
+            flat.gen_DPtOverPt = gen_DPtOverPt;
+            flat.melaAngles = melaAngles;
+            flat.visMelaAngles = visMelaAngles;
+            flat.MT2 = MT2;
+            return flat;
+        }
+    };
+}
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cp3_llbb/HHAnalysis/interface/Types.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace HH {
+
+    // Cartesian three- and four-vectors in double precision, for the angular kernels below
+    struct Vector3 {
+        double x = 0., y = 0., z = 0.;
+
+        Vector3() = default;
+        Vector3(double x, double y, double z): x(x), y(y), z(z) {}
+
+        double Dot(const Vector3& o) const { return x * o.x + y * o.y + z * o.z; }
+        Vector3 Cross(const Vector3& o) const { return Vector3(y * o.z - z * o.y, z * o.x - x * o.z, x * o.y - y * o.x); }
+        Vector3 operator-(const Vector3& o) const { return Vector3(x - o.x, y - o.y, z - o.z); }
+        double R() const { return std::sqrt(Dot(*this)); }
+        Vector3 Unit() const {
+            double r = R();
+            return (r == 0) ? *this : Vector3(x / r, y / r, z / r);
+        }
+        // Cosine of the angle between the two vectors, clamped in [-1, 1] as in ROOT::Math::VectorUtil::CosTheta
+        double CosTheta(const Vector3& o) const {
+            double c = Dot(o) / std::sqrt(Dot(*this) * o.Dot(o));
+            return std::max(-1., std::min(1., c));
+        }
+    };
+
+    struct CartesianP4 {
+        double x = 0., y = 0., z = 0., t = 0.;
+
+        CartesianP4() = default;
+        CartesianP4(double x, double y, double z, double t): x(x), y(y), z(z), t(t) {}
+        explicit CartesianP4(const LorentzVector& p4): x(p4.Px()), y(p4.Py()), z(p4.Pz()), t(p4.E()) {}
+
+        CartesianP4 operator+(const CartesianP4& o) const { return CartesianP4(x + o.x, y + o.y, z + o.z, t + o.t); }
+        Vector3 Vect() const { return Vector3(x, y, z); }
+    };
+
+    // Boost to the rest frame of a four-vector, ie. ROOT::Math::Boost(-p.X() / p.T(), -p.Y() / p.T(), -p.Z() / p.T())
+    class RestFrameBoost {
+        public:
+            explicit RestFrameBoost(const CartesianP4& p):
+                m_bx(-p.x / p.t), m_by(-p.y / p.t), m_bz(-p.z / p.t) {
+                m_gamma = 1. / std::sqrt(1. - (m_bx * m_bx + m_by * m_by + m_bz * m_bz));
+                m_bgamma = m_gamma * m_gamma / (1. + m_gamma);
+            }
+
+            CartesianP4 operator()(const CartesianP4& v) const {
+                double bp = m_bx * v.x + m_by * v.y + m_bz * v.z;
+                double a = m_bgamma * bp + m_gamma * v.t;
+                return CartesianP4(v.x + a * m_bx, v.y + a * m_by, v.z + a * m_bz, m_gamma * (v.t + bp));
+            }
+
+        private:
+            double m_bx, m_by, m_bz;
+            double m_gamma, m_bgamma;
+    };
+
+    // Axis of the Collins-Soper frame, for the beams boosted with 'boost'
+    inline Vector3 collinsSoperAxis(const RestFrameBoost& boost, double ebeam) {
+        Vector3 b_p1 = boost(CartesianP4(0, 0, ebeam, ebeam)).Vect();
+        Vector3 b_p2 = boost(CartesianP4(0, 0, -ebeam, ebeam)).Vect();
+        return (b_p1.Unit() - b_p2.Unit()).Unit();
+    }
+
+    // cos theta star angle of h1 in the Collins Soper frame of h1 + h2
+    inline double cosThetaStarCS(const CartesianP4& h1, const CartesianP4& h2, double ebeam = 6500) {
+        RestFrameBoost boost(h1 + h2);
+        return collinsSoperAxis(boost, ebeam).CosTheta(boost(h1).Vect());
+    }
+
+    // Inputs of the MELA angles for one llmetjj candidate: the full (llmet) and visible (ll) H(ww) candidates share
+    // the leptons, the jets and the H(bb) candidate
+    struct MELAInputs {
+        CartesianP4 llmet;
+        CartesianP4 ll;
+        CartesianP4 jj;
+        CartesianP4 lep1;
+        CartesianP4 lep2;
+        CartesianP4 jet1;
+        CartesianP4 jet2;
+    };
+
+    struct MELAResults {
+        MELAAngles full;
+        MELAAngles visible;
+        // cos(full.thetaStar), without the acos / cos round trip
+        float cosThetaStar_CS;
+    };
+
+    namespace mela {
+
+        // Quantities of the jj side which do not depend on the H(ww) candidate
+        struct DijetSide {
+            RestFrameBoost boost;
+            Vector3 jet1;  // in the jj rest frame
+            double jet1_mag;
+
+            DijetSide(const MELAInputs& in):
+                boost(in.jj), jet1(boost(in.jet1).Vect()), jet1_mag(std::sqrt(jet1.Dot(jet1))) {}
+        };
+
+        // MELA angles as taken from https://arxiv.org/pdf/1208.4018v3.pdf, for the H(ww) candidate q1. Returns cos(thetaStar)
+        template <typename Acos>
+        double computeAngles(const CartesianP4& q1, const MELAInputs& in, const DijetSide& jj_side, double ebeam, Acos acos, MELAAngles& angles) {
+            // q1 + q2 rest frame (prefix 'b' for 'boosted')
+            RestFrameBoost boost(q1 + in.jj);
+            Vector3 b_q1 = boost(q1).Vect();
+            Vector3 b_q11 = boost(in.lep1).Vect();
+            Vector3 b_q12 = boost(in.lep2).Vect();
+            Vector3 b_q21 = boost(in.jet1).Vect();
+            Vector3 b_q22 = boost(in.jet2).Vect();
+            // q1 rest frame and q2 rest frame
+            RestFrameBoost boost1(q1);
+            Vector3 b1_q2 = boost1(in.jj).Vect();
+            Vector3 b1_q11 = boost1(in.lep1).Vect();
+            Vector3 b2_q1 = jj_side.boost(q1).Vect();
+
+            // Reference vectors
+            Vector3 n1 = b_q11.Cross(b_q12).Unit();
+            Vector3 n2 = b_q21.Cross(b_q22).Unit();
+            Vector3 nsc = Vector3(0., 0., 1.).Cross(b_q1).Unit();
+
+            double n1_x_n2 = b_q1.Dot(n1.Cross(n2));
+            double n1_x_nsc = b_q1.Dot(n1.Cross(nsc));
+            angles.phi = n1_x_n2 / std::abs(n1_x_n2) * acos(- n1.Dot(n2));
+            float phi1 = n1_x_nsc / std::abs(n1_x_nsc) * acos(n1.Dot(nsc));
+            angles.psi = phi1 + angles.phi / 2.;
+            angles.theta1 = acos(- b1_q2.Dot(b1_q11) / std::sqrt(b1_q2.Dot(b1_q2)) / std::sqrt(b1_q11.Dot(b1_q11)));
+            angles.theta2 = acos(- b2_q1.Dot(jj_side.jet1) / std::sqrt(b2_q1.Dot(b2_q1)) / jj_side.jet1_mag);
+            // thetaStar is defined in the Collins-Soper frame
+            double cosThetaStar = collinsSoperAxis(boost, ebeam).CosTheta(b_q1);
+            angles.thetaStar = acos(cosThetaStar);
+
+            return cosThetaStar;
+        }
+    }
+
+    // MELA angles of the full and visible H(ww) candidates, and cos theta star in the Collins-Soper frame, in one pass.
+    // 'acos' is called for every angle, so that the caller can choose its implementation
+    template <typename Acos>
+    MELAResults computeMELAAngles(const MELAInputs& in, Acos acos, double ebeam = 6500) {
+        MELAResults results;
+        mela::DijetSide jj_side(in);
+        results.cosThetaStar_CS = mela::computeAngles(in.llmet, in, jj_side, ebeam, acos, results.full);
+        mela::computeAngles(in.ll, in, jj_side, ebeam, acos, results.visible);
+        return results;
+    }
+
+    template <typename Acos>
+    void computeMELAAngles(const std::vector<MELAInputs>& inputs, std::vector<MELAResults>& results, Acos acos, double ebeam = 6500) {
+        results.resize(inputs.size());
+        for (size_t i = 0; i < inputs.size(); i++)
+            results[i] = computeMELAAngles(inputs[i], acos, ebeam);
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace HH {
+
+    // Arguments of asymm_mt2_lester_bisect::get_mT2 for one candidate
+    struct MT2Input {
+        double mVis1, pxVis1, pyVis1;
+        double mVis2, pxVis2, pyVis2;
+        double pxMiss, pyMiss;
+        double mInvis1, mInvis2;
+    };
+
+    struct MT2Result {
+        // MT2, or MT2Engine::ERROR if the computation failed. With a threshold, MT2Engine::ABOVE_THRESHOLD or
+        // MT2Engine::BELOW_THRESHOLD instead of MT2
+        double MT2;
+        // Number of ellipse disjointness tests performed
+        unsigned int iterations;
+    };
+
+    // Asymmetric MT2 with the bisection algorithm of https://arxiv.org/pdf/1411.4312v5.pdf (interface/lester_mt2_bisect.h),
+    // for many candidates at once. The bisections of all the candidates advance together, one step at a time, so that the
+    // ellipse tests of each step run in a single loop over contiguous arrays which the compiler can vectorize.
+    // For a given precision the results are identical to get_mT2.
+    class MT2Engine {
+        public:
+            static constexpr double ERROR = -1;
+            // Results with a threshold, which compare with the threshold as MT2 does
+            static constexpr double ABOVE_THRESHOLD = std::numeric_limits<float>::max();
+            static constexpr double BELOW_THRESHOLD = -2;
+
+            // precision: absolute precision on MT2 (0: machine precision).
+            // threshold: if positive, stop as soon as MT2 is known to be above or below the threshold, whatever the precision,
+            // and return ABOVE_THRESHOLD or BELOW_THRESHOLD: the value where the bisection stopped is not MT2.
+            MT2Engine(double precision = 0, double threshold = 0);
+
+            void compute(const std::vector<MT2Input>& inputs, std::vector<MT2Result>& results);
+
+        private:
+            enum class Phase: uint8_t {
+                Bracketing, // Looking for an upper bound, doubling mUpper
+                Bisecting
+            };
+
+            // Take lane i out of the active lanes, storing its result
+            void finish(size_t i, double MT2, std::vector<MT2Result>& results);
+            // Disjointness test of the two ellipses for all the active lanes, at the trial masses m_trialMSq
+            void testEllipses(size_t n);
+
+            double m_precision;
+            double m_threshold;
+
+            // State of the active lanes. Finished lanes are swapped with the last active one, so that the active lanes
+            // always occupy the beginning of the arrays
+            size_t m_n_active = 0;
+            std::vector<size_t> m_index; // Index of the candidate in the input
+            std::vector<Phase> m_phase;
+            std::vector<uint8_t> m_goLow;
+            std::vector<unsigned int> m_attempts;
+            std::vector<unsigned int> m_iterations;
+            std::vector<double> m_mLower, m_mUpper, m_trialM, m_trialMSq;
+            std::vector<double> m_msSq, m_sx, m_sy, m_mpSq, m_mtSq, m_tx, m_ty, m_mqSq, m_pxMiss, m_pyMiss;
+            // Result of the test: 0 for overlapping ellipses, 1 for disjoint ellipses, 2 for degenerate ellipses
+            std::vector<int32_t> m_disjoint;
+    };
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cp3_llbb/HHAnalysis/interface/Types.h>
+#include <cp3_llbb/HHAnalysis/interface/FourVector.h>
+
+#include <vector>
+
+namespace HH {
+
+    // Structure-of-arrays view of a collection of four-vectors. The cartesian components are computed once per object
+    struct KinematicsSoA {
+        std::vector<float> pt;
+        std::vector<float> eta;
+        std::vector<float> phi;
+        std::vector<float> E;
+        std::vector<float> px;
+        std::vector<float> py;
+        std::vector<float> pz;
+
+        void clear();
+        void push_back(const LorentzVector& p4);
+        size_t size() const { return pt.size(); }
+        // Four-vector of object i, with both its polar and cartesian components already known
+        FourVector fourVector(size_t i) const { return FourVector(pt[i], eta[i], phi[i], E[i], px[i], py[i], pz[i]); }
+    };
+
+    // Row-major matrix of a pairwise quantity between two collections
+    struct PairMatrix {
+        std::vector<float> values;
+        size_t rows = 0;
+        size_t columns = 0;
+
+        float operator()(size_t i, size_t j) const { return values[i * columns + j]; }
+        void resize(size_t n_rows, size_t n_columns) {
+            rows = n_rows;
+            columns = n_columns;
+            values.resize(n_rows * n_columns);
+        }
+    };
+
+    // Pairwise kernels, vectorized with AVX or SSE2 when the target supports it, scalar otherwise.
+    // DeltaPhi (signed, from a to b) and DeltaR give the same values as ROOT::Math::VectorUtil
+    void computeDeltaPhiDeltaR(const KinematicsSoA& a, const KinematicsSoA& b, PairMatrix& dphi, PairMatrix& dr);
+    // Invariant mass and pt of all the pairs of objects within a collection. Only the upper triangle (i < j) is filled
+    void computePairMassPt(const KinematicsSoA& a, PairMatrix& mass, PairMatrix& pt);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cp3_llbb/HHAnalysis/interface/Types.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace HH {
+
+    // Bitmask over the objects of a producer collection, one bit per object
+    class ObjectMask {
+        public:
+            size_t size() const { return m_size; }
+            bool test(size_t i) const { return (m_words[i / 64] >> (i % 64)) & 1; }
+            size_t count() const;
+
+            // Call f(i) for every object i passing the selection, in increasing order
+            template <typename Function>
+            void forEach(Function f) const {
+                for (size_t iword = 0; iword < m_words.size(); iword++) {
+                    for (uint64_t word = m_words[iword]; word != 0; word &= word - 1)
+                        f(iword * 64 + __builtin_ctzll(word));
+                }
+            }
+
+            // Pack one byte per object, 0 (fail) or 1 (pass)
+            void pack(const std::vector<uint8_t>& pass);
+
+        private:
+            std::vector<uint64_t> m_words;
+            size_t m_size = 0;
+    };
+
+    // Preselection of the objects of a producer collection, evaluating one predicate at a time over the columns of the
+    // producer. Each predicate is a loop without branches over contiguous arrays, which the compiler can vectorize,
+    // updating one byte per object. The result is packed in a bitmask by mask().
+    class Preselection {
+        public:
+            // Start a new selection over n objects, all passing
+            Preselection& reset(size_t n);
+            // pt > ptCut and |eta| < etaCut. If given, the pt of each object is first multiplied by the corresponding factor
+            Preselection& kinematics(const std::vector<LorentzVector>& p4, float ptCut, float etaCut, const std::vector<float>* ptFactors = nullptr);
+            // Flag set
+            Preselection& flag(const std::vector<bool>& flags);
+            // value < cut
+            Preselection& below(const std::vector<float>& values, float cut);
+
+            const ObjectMask& mask();
+
+        private:
+            std::vector<uint8_t> m_pass;
+            ObjectMask m_mask;
+    };
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include <Math/Vector4D.h>
 #include <cp3_llbb/HHAnalysis/interface/Indices.h>
@@ -7,6 +8,13 @@
 namespace HH {
     typedef ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiE4D<float>> LorentzVector;
 
+    // Binned efficiency with its errors, from a single lookup
+    struct EfficiencyValue {
+        float value = 1.;
+        float error_low = 0.;
+        float error_high = 0.;
+    };
+
     struct Lepton {
         LorentzVector p4;
         LorentzVector gen_p4;
@@ -14,7 +22,7 @@ namespace HH {
         int idx;
         int8_t hlt_idx = -1; // Index to the matched HLT object. -1 if no match. 
                              // Example : t->Draw("hh_leptons.p4.Pt() - hlt_object_p4[hh_leptons.hlt_idx].Pt()","hh_leptons.hlt_idx != -1","")
-        bool hlt_already_tried_matching = false; // do the matching only once, even when the lepton is in several Dilepton
+        bool hlt_already_tried_matching = false; // the matching has been attempted. For a lepton in several Dilepton, the results are the ones of the last pair tried
         float hlt_DR_matchedObject = std::numeric_limits<float>::max();
         float hlt_DPtOverPt_matchedObject = std::numeric_limits<float>::max();
         bool hlt_leg1;
@@ -33,6 +41,18 @@ namespace HH {
         float gen_DR;
         float gen_DPtOverPt;
         float sc_eta; // Only valid for electrons, transient
+        // Trigger leg efficiencies, transient, only evaluated for the channels of the pairs tried
+        // SF: legs of the same-flavour dilepton trigger, DF: legs of the different-flavour dilepton trigger
+        uint8_t hlt_efficiencies_cached = 0; // 1: SF legs evaluated, 2: DF legs evaluated
+        EfficiencyValue hlt_eff_SF_leg1;
+        EfficiencyValue hlt_eff_SF_leg2;
+        EfficiencyValue hlt_eff_DF_leg1;
+        EfficiencyValue hlt_eff_DF_leg2;
+        // L1 EMTF geometry (translated L1T phi, endcap, CSC sector and overlap, -1 if none), only valid for muons, transient
+        float l1t_phi = 0;
+        int8_t csc_endcap = 0;
+        int8_t csc_sector = -1;
+        int8_t csc_overlap = -1;
     };
     struct Dilepton {
         LorentzVector p4;
@@ -93,22 +113,6 @@ namespace HH {
         float gen_DPhi;
         float gen_DPtOverPt;
     };
-    struct DileptonMet : public Dilepton, public Met {
-        LorentzVector p4;
-        LorentzVector gen_p4;
-        int ill; // index in the HH::Dilepton collection
-        int imet; // index in the HH::Met collection
-        float DPhi_ll_met;
-        float minDPhi_l_met;
-        float maxDPhi_l_met;
-        float MT;
-        float MT_formula;
-        float projectedMet;
-        bool gen_matched;
-        float gen_DR;
-        float gen_DPhi;
-        float gen_DPtOverPt;
-    };
     struct Jet {
         LorentzVector p4;
         LorentzVector gen_p4;
@@ -121,6 +125,7 @@ namespace HH {
         //bool btag_T;
         float CSV;
         float CMVAv2;
+        float JP; // Transient, only filled for the jp jet pair ordering
         bool gen_matched_bParton;
         bool gen_matched_bHadron;
         bool gen_matched;
@@ -175,16 +180,17 @@ namespace HH {
         float psi;
     };
 
-    struct DileptonMetDijet : public DileptonMet, public Dijet {
+    // Flat layout: every quantity is stored once, the constituents being only referenced by index
+    struct DileptonMetDijet {
         LorentzVector p4;
         LorentzVector lep1_p4;
         LorentzVector lep2_p4;
         LorentzVector jet1_p4;
         LorentzVector jet2_p4;
-        LorentzVector met_p4;
+        LorentzVector met_p4; // not stored, recomputed on read as p4 - ll_p4 - jj_p4
         LorentzVector ll_p4;
         LorentzVector jj_p4;
-        LorentzVector lljj_p4;
+        LorentzVector lljj_p4() const { return ll_p4 + jj_p4; }
 
         LorentzVector gen_p4;
         LorentzVector gen_lep1_p4;
@@ -194,9 +200,57 @@ namespace HH {
         LorentzVector gen_met_p4;
         LorentzVector gen_ll_p4;
         LorentzVector gen_jj_p4;
-        LorentzVector gen_lljj_p4;
-        //int illmet; // index in the HH::DileptonMet collection
-        //int ijj; // index in the HH::Dijet collection
+        LorentzVector gen_lljj_p4() const { return gen_ll_p4 + gen_jj_p4; }
+
+        // dilepton
+        int ilep1; // index in the HH::Lepton collection
+        int ilep2; // index in the HH::Lepton collection
+        bool isOS; // Opposite Sign
+        bool isPlusMinus;
+        bool isMinusPlus;
+        bool isMuMu;
+        bool isElEl;
+        bool isElMu;
+        bool isMuEl;
+        bool isSF; // Same Flavour
+        float DR_l_l;
+        float DPhi_l_l;
+        float ht_l_l;
+        float trigger_efficiency;
+        float trigger_efficiency_downVariated;
+        float trigger_efficiency_upVariated;
+
+        // met
+        int imet; // index in the HH::Met collection
+        bool isNoHF;
+
+        // dilepton + met
+        float DPhi_ll_met;
+        float minDPhi_l_met;
+        float maxDPhi_l_met;
+        float MT;
+        float MT_formula;
+        float projectedMet;
+
+        // dijet
+        int ijet1; // index in the HH::Jet collection
+        int ijet2; // index in the HH::Jet collection
+        bool btag_MM;
+        float sumCSV;
+        float sumCMVAv2;
+        float DR_j_j;
+        float DPhi_j_j;
+        float ht_j_j;
+        bool gen_matched_bbPartons;
+        bool gen_matched_bbHadrons;
+        bool gen_bb;
+        bool gen_bc;
+        bool gen_bl;
+        bool gen_cc;
+        bool gen_cl;
+        bool gen_ll;
+
+        // dilepton + met + dijet
         float DPhi_jj_met;
         float minDPhi_j_met;
         float maxDPhi_j_met;
@@ -214,8 +268,43 @@ namespace HH {
         float gen_DPtOverPt;
         MELAAngles melaAngles;
         MELAAngles visMelaAngles;
-        float MT2;
+        float MT2; // -1 if the computation failed. With mt2Threshold, 3.4e38 above the threshold and -2 below
+    };
+
+    // Lightweight handle on an opposite-sign lepton pair, used to rank the pairs
+    // before running the HLT matching on them. Not stored in the tree.
+    struct DileptonCandidate {
+        unsigned int ilep1; // index in the HH::Lepton collection
+        unsigned int ilep2; // index in the HH::Lepton collection
+        float ht_l_l;
     };
-}
 
+    // In-memory dilepton + MET composite: the constituents are referenced by index
+    // and only the variables defined at this level are held. Not stored in the tree.
+    struct DileptonMetCandidate {
+        unsigned int ill; // index in the HH::Dilepton collection
+        unsigned int imet; // index in the HH::Met collection
+        LorentzVector p4;
+        LorentzVector gen_p4;
+        float DPhi_ll_met;
+        float minDPhi_l_met;
+        float maxDPhi_l_met;
+        float MT;
+        float MT_formula;
+        float projectedMet;
+        bool gen_matched;
+        float gen_DR;
+        float gen_DPhi;
+        float gen_DPtOverPt;
+    };
 
+    // Lightweight handle on a (llmet, jj) combination, used to rank the combinations
+    // before building the full DileptonMetDijet. Not stored in the tree.
+    struct DileptonMetDijetCandidate {
+        unsigned int illmet; // index in the HH::DileptonMetCandidate collection
+        unsigned int ijj; // index in the HH::Dijet collection, once the dijet is built
+        int ijet1; // indices in the HH::Jet collection
+        int ijet2;
+        float sumCMVAv2;
+    };
+}
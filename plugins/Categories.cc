@@ -4,6 +4,8 @@
 
 #include <cp3_llbb/HHAnalysis/interface/Categories.h>
 
+#include <algorithm>
+#include <cmath>
 #include <regex>
 
 // ***** ***** *****
@@ -29,6 +31,30 @@ const std::vector<HH::DileptonMetDijet>& DileptonCategory::getDileptonMetDijets(
     return hh_analyzer.llmetjj;
 }
 
+size_t DileptonCategory::countMuons(const ProducersManager& producers, float ptCut) const {
+    const MuonsProducer& muons = producers.get<MuonsProducer>(m_muons_producer);
+    size_t n = 0;
+    for (size_t imuon = 0; imuon < muons.p4.size(); imuon++) {
+        if (muons.p4[imuon].Pt() > ptCut
+            && fabs(muons.p4[imuon].Eta()) < m_muonEtaCut
+            && muons.isTight[imuon] && muons.relativeIsoR04_deltaBeta[imuon] < m_muonTightIsoCut)
+            n++;
+    }
+    return n;
+}
+
+size_t DileptonCategory::countElectrons(const ProducersManager& producers, float ptCut) const {
+    const ElectronsProducer& electrons = producers.get<ElectronsProducer>(m_electrons_producer);
+    size_t n = 0;
+    for (size_t ielectron = 0; ielectron < electrons.p4.size(); ielectron++) {
+        if (electrons.p4[ielectron].Pt() > ptCut
+            && fabs(electrons.p4[ielectron].Eta()) < m_electronEtaCut
+            && (m_electron_medium_wp_name.empty() || electrons.ids[ielectron][m_electron_medium_wp_name]))
+            n++;
+    }
+    return n;
+}
+
 // ***** ***** *****
 // Dilepton Mu-Mu category
 // ***** ***** *****
@@ -41,8 +67,9 @@ void MuMuCategory::configure(const edm::ParameterSet& conf) {
 }
 
 bool MuMuCategory::event_in_category_pre_analyzers(const ProducersManager& producers) const {
-    const MuonsProducer& muons = producers.get<MuonsProducer>("muons");
-    return (muons.p4.size() >= 2);
+    // Same requirements as in the post-analyzer gate, on the producer collection, loosened to the analyzer cuts
+    return (countMuons(producers, std::min(m_leadingLeptonPtCut, m_leadingMuonPtCut)) >= 1) &&
+        (countMuons(producers, std::min(m_subleadingLeptonPtCut, m_subleadingMuonPtCut)) >= 2);
 };
 
 bool MuMuCategory::event_in_category_post_analyzers(const ProducersManager& producers, const AnalyzersManager& analyzers) const {
@@ -88,8 +115,9 @@ void ElElCategory::configure(const edm::ParameterSet& conf) {
 }
 
 bool ElElCategory::event_in_category_pre_analyzers(const ProducersManager& producers) const {
-    const ElectronsProducer& electrons = producers.get<ElectronsProducer>("electrons");
-    return (electrons.p4.size() >= 2);
+    // Same requirements as in the post-analyzer gate, on the producer collection, loosened to the analyzer cuts
+    return (countElectrons(producers, std::min(m_leadingLeptonPtCut, m_leadingElectronPtCut)) >= 1) &&
+        (countElectrons(producers, std::min(m_subleadingLeptonPtCut, m_subleadingElectronPtCut)) >= 2);
 };
 
 bool ElElCategory::event_in_category_post_analyzers(const ProducersManager& producers, const AnalyzersManager& analyzers) const {
@@ -135,9 +163,9 @@ void ElMuCategory::configure(const edm::ParameterSet& conf) {
 }
 
 bool ElMuCategory::event_in_category_pre_analyzers(const ProducersManager& producers) const {
-    const ElectronsProducer& electrons = producers.get<ElectronsProducer>("electrons");
-    const MuonsProducer& muons = producers.get<MuonsProducer>("muons");
-    return ((electrons.p4.size() + muons.p4.size()) >= 2);
+    // Same requirements as in the post-analyzer gate, on the producer collections, loosened to the analyzer cuts
+    return (countElectrons(producers, std::min(m_leadingLeptonPtCut, m_leadingElectronPtCut)) >= 1) &&
+        (countMuons(producers, std::min(m_subleadingLeptonPtCut, m_subleadingMuonPtCut)) >= 1);
 };
 
 bool ElMuCategory::event_in_category_post_analyzers(const ProducersManager& producers, const AnalyzersManager& analyzers) const {
@@ -183,9 +211,9 @@ void MuElCategory::configure(const edm::ParameterSet& conf) {
 }
 
 bool MuElCategory::event_in_category_pre_analyzers(const ProducersManager& producers) const {
-    const ElectronsProducer& electrons = producers.get<ElectronsProducer>("electrons");
-    const MuonsProducer& muons = producers.get<MuonsProducer>("muons");
-    return ((electrons.p4.size() + muons.p4.size()) >= 2);
+    // Same requirements as in the post-analyzer gate, on the producer collections, loosened to the analyzer cuts
+    return (countMuons(producers, std::min(m_leadingLeptonPtCut, m_leadingMuonPtCut)) >= 1) &&
+        (countElectrons(producers, std::min(m_subleadingLeptonPtCut, m_subleadingElectronPtCut)) >= 1);
 };
 
 bool MuElCategory::event_in_category_post_analyzers(const ProducersManager& producers, const AnalyzersManager& analyzers) const {
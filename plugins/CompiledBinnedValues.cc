@@ -0,0 +1,101 @@
+#include <cp3_llbb/HHAnalysis/interface/CompiledBinnedValues.h>
+#include <cp3_llbb/HHAnalysis/interface/EfficiencyTables.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace HH {
+
+namespace {
+
+    // Union of the edges of an axis over all the parts
+    std::vector<float> mergeEdges(const std::vector<const CompiledAxis*>& axes) {
+        std::vector<float> edges;
+        for (const CompiledAxis* axis: axes)
+            edges.insert(edges.end(), axis->edges, axis->edges + axis->n_bins + 1);
+        std::sort(edges.begin(), edges.end());
+        edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+        return edges;
+    }
+}
+
+MergedBinnedValues::MergedBinnedValues(const std::vector<std::pair<const CompiledBinnedValues*, double>>& parts) {
+    if (parts.empty())
+        throw std::invalid_argument("No table to merge");
+
+    std::vector<const CompiledAxis*> x_axes, y_axes;
+    double total_weight = 0;
+    for (const auto& part: parts) {
+        if (part.first->x.variable != parts.front().first->x.variable || part.first->y.variable != parts.front().first->y.variable)
+            throw std::invalid_argument("Cannot merge tables binned in different variables");
+        x_axes.push_back(&part.first->x);
+        y_axes.push_back(&part.first->y);
+        total_weight += part.second;
+    }
+    m_x_edges = mergeEdges(x_axes);
+    m_y_edges = mergeEdges(y_axes);
+
+    // Each bin of the union is within a single bin of every part: the parts are evaluated at its lower edges, where their
+    // errors are doubled if the bin is outside of their binning. Outside of the union, every part is out of its binning,
+    // and the errors without doubling are all doubled once.
+    size_t n_x = m_x_edges.size() - 1, n_y = m_y_edges.size() - 1;
+    m_values.resize(n_x * n_y);
+    m_out_of_range_values.resize(n_x * n_y);
+    for (size_t i = 0; i < n_x; i++) {
+        for (size_t j = 0; j < n_y; j++) {
+            double value = 0, error_low2 = 0, error_high2 = 0, in_range_error_low2 = 0, in_range_error_high2 = 0;
+            for (const auto& part: parts) {
+                EfficiencyValue v = part.first->at(m_x_edges[i], m_y_edges[j]);
+                double weight = part.second / total_weight;
+                value += weight * v.value;
+                error_low2 += weight * weight * v.error_low * v.error_low;
+                error_high2 += weight * weight * v.error_high * v.error_high;
+
+                const CompiledAxis& x = part.first->x;
+                const CompiledAxis& y = part.first->y;
+                bool out_of_range = false;
+                EfficiencyValue in_range = part.first->values[x.find(m_x_edges[i], out_of_range) * y.n_bins + y.find(m_y_edges[j], out_of_range)];
+                in_range_error_low2 += weight * weight * in_range.error_low * in_range.error_low;
+                in_range_error_high2 += weight * weight * in_range.error_high * in_range.error_high;
+            }
+            m_values[i * n_y + j] = {float(value), float(std::sqrt(error_low2)), float(std::sqrt(error_high2))};
+            m_out_of_range_values[i * n_y + j] = {float(value), float(2 * std::sqrt(in_range_error_low2)), float(2 * std::sqrt(in_range_error_high2))};
+        }
+    }
+
+    m_table = {
+        {parts.front().first->x.variable, m_x_edges.data(), uint32_t(n_x)},
+        {parts.front().first->y.variable, m_y_edges.data(), uint32_t(n_y)},
+        m_values.data(),
+        m_out_of_range_values.data()
+    };
+}
+
+uint64_t contentHash(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("Cannot open " + path);
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (auto it = std::istreambuf_iterator<char>(file); it != std::istreambuf_iterator<char>(); ++it) {
+        hash ^= static_cast<unsigned char>(*it);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+const CompiledBinnedValues* findCompiledBinnedValues(const std::string& relative_path, const std::string& full_path) {
+    for (const auto& entry: efficiency_tables::all) {
+        if (relative_path != entry.path)
+            continue;
+
+        if (contentHash(full_path) != entry.hash)
+            throw std::runtime_error(full_path + " changed since interface/EfficiencyTables.h was generated, run scripts/generateEfficiencyTables.py");
+        return entry.table;
+    }
+    return nullptr;
+}
+
+}
@@ -0,0 +1,415 @@
+#include <cp3_llbb/HHAnalysis/interface/CutExpression.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+
+namespace HH {
+
+namespace {
+
+    using Op = CutProgram::Op;
+
+    float unary(Op op, float x) {
+        switch (op) {
+            case Op::Negate: return -x;
+            case Op::Not: return !x;
+            case Op::Abs: return std::abs(x);
+            case Op::Sqrt: return std::sqrt(x);
+            default: return x;
+        }
+    }
+
+    float binary(Op op, float a, float b) {
+        switch (op) {
+            case Op::Add: return a + b;
+            case Op::Subtract: return a - b;
+            case Op::Multiply: return a * b;
+            case Op::Divide: return a / b;
+            case Op::Less: return a < b;
+            case Op::LessEqual: return a <= b;
+            case Op::Greater: return a > b;
+            case Op::GreaterEqual: return a >= b;
+            case Op::Equal: return a == b;
+            case Op::NotEqual: return a != b;
+            case Op::And: return (a != 0) && (b != 0);
+            case Op::Or: return (a != 0) || (b != 0);
+            default: return a;
+        }
+    }
+
+    struct Node {
+        Op op;
+        float value = 0;
+        uint16_t index = 0;
+        std::unique_ptr<Node> left;
+        std::unique_ptr<Node> right;
+
+        bool constant() const { return op == Op::Constant; }
+    };
+    using NodePtr = std::unique_ptr<Node>;
+}
+
+// Recursive descent parser building the expression tree, folding the constants, then emitting the program
+class CutParser {
+    public:
+        CutParser(const std::string& expression, const std::vector<std::string>& variables, CutProgram& program):
+            m_expression(expression), m_variables(variables), m_program(program) {}
+
+        void compile() {
+            skipSpaces();
+            if (m_pos == m_expression.size())
+                return;
+
+            NodePtr root = parseOr();
+            skipSpaces();
+            if (m_pos != m_expression.size())
+                error("unexpected '" + m_expression.substr(m_pos, 1) + "'");
+
+            size_t depth = 0;
+            size_t max_depth = 0;
+            emit(*root, depth, max_depth);
+            if (max_depth > CutProgram::max_stack_size || m_program.m_variables.size() > CutProgram::max_stack_size)
+                error("expression too complex");
+        }
+
+    private:
+        [[noreturn]] void error(const std::string& message) const {
+            throw std::invalid_argument("Invalid cut '" + m_expression + "' at position " + std::to_string(m_pos) + ": " + message);
+        }
+
+        void skipSpaces() {
+            while (m_pos < m_expression.size() && std::isspace(static_cast<unsigned char>(m_expression[m_pos])))
+                m_pos++;
+        }
+
+        // Consume 'token' if it is next
+        bool accept(const std::string& token) {
+            skipSpaces();
+            if (m_expression.compare(m_pos, token.size(), token) != 0)
+                return false;
+            // Keywords must not be the beginning of an identifier
+            if (std::isalpha(static_cast<unsigned char>(token[0])) && m_pos + token.size() < m_expression.size()) {
+                char next = m_expression[m_pos + token.size()];
+                if (std::isalnum(static_cast<unsigned char>(next)) || next == '_')
+                    return false;
+            }
+            m_pos += token.size();
+            return true;
+        }
+
+        void expect(const std::string& token) {
+            if (!accept(token))
+                error("expected '" + token + "'");
+        }
+
+        static NodePtr makeConstant(float value) {
+            NodePtr node(new Node());
+            node->op = Op::Constant;
+            node->value = value;
+            return node;
+        }
+
+        static NodePtr makeUnary(Op op, NodePtr operand) {
+            if (operand->constant())
+                return makeConstant(unary(op, operand->value));
+            NodePtr node(new Node());
+            node->op = op;
+            node->left = std::move(operand);
+            return node;
+        }
+
+        static NodePtr makeBinary(Op op, NodePtr left, NodePtr right) {
+            if (left->constant() && right->constant())
+                return makeConstant(binary(op, left->value, right->value));
+            NodePtr node(new Node());
+            node->op = op;
+            node->left = std::move(left);
+            node->right = std::move(right);
+            return node;
+        }
+
+        NodePtr parseOr() {
+            NodePtr node = parseAnd();
+            while (accept("||") || accept("or"))
+                node = makeBinary(Op::Or, std::move(node), parseAnd());
+            return node;
+        }
+
+        NodePtr parseAnd() {
+            NodePtr node = parseComparison();
+            while (accept("&&") || accept("and"))
+                node = makeBinary(Op::And, std::move(node), parseComparison());
+            return node;
+        }
+
+        NodePtr parseComparison() {
+            NodePtr node = parseSum();
+            // Two-character operators first
+            static const std::vector<std::pair<std::string, Op>> operators = {
+                {"<=", Op::LessEqual}, {">=", Op::GreaterEqual}, {"==", Op::Equal}, {"!=", Op::NotEqual},
+                {"<", Op::Less}, {">", Op::Greater}
+            };
+            for (const auto& op: operators) {
+                if (accept(op.first))
+                    return makeBinary(op.second, std::move(node), parseSum());
+            }
+            return node;
+        }
+
+        NodePtr parseSum() {
+            NodePtr node = parseProduct();
+            while (true) {
+                if (accept("+"))
+                    node = makeBinary(Op::Add, std::move(node), parseProduct());
+                else if (accept("-"))
+                    node = makeBinary(Op::Subtract, std::move(node), parseProduct());
+                else
+                    return node;
+            }
+        }
+
+        NodePtr parseProduct() {
+            NodePtr node = parseUnary();
+            while (true) {
+                if (accept("*"))
+                    node = makeBinary(Op::Multiply, std::move(node), parseUnary());
+                else if (accept("/"))
+                    node = makeBinary(Op::Divide, std::move(node), parseUnary());
+                else
+                    return node;
+            }
+        }
+
+        NodePtr parseUnary() {
+            if (accept("-"))
+                return makeUnary(Op::Negate, parseUnary());
+            if (accept("!") || accept("not"))
+                return makeUnary(Op::Not, parseUnary());
+            if (accept("+"))
+                return parseUnary();
+            return parsePrimary();
+        }
+
+        NodePtr parsePrimary() {
+            skipSpaces();
+            if (m_pos == m_expression.size())
+                error("unexpected end of expression");
+
+            if (accept("(")) {
+                NodePtr node = parseOr();
+                expect(")");
+                return node;
+            }
+
+            char c = m_expression[m_pos];
+            if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+                const char* begin = m_expression.c_str() + m_pos;
+                char* end = nullptr;
+                float value = std::strtof(begin, &end);
+                if (end == begin)
+                    error("invalid number");
+                m_pos += end - begin;
+                return makeConstant(value);
+            }
+
+            if (!std::isalpha(static_cast<unsigned char>(c)) && c != '_')
+                error("unexpected '" + std::string(1, c) + "'");
+
+            size_t begin = m_pos;
+            while (m_pos < m_expression.size() && (std::isalnum(static_cast<unsigned char>(m_expression[m_pos])) || m_expression[m_pos] == '_'))
+                m_pos++;
+            std::string name = m_expression.substr(begin, m_pos - begin);
+
+            if (name == "true")
+                return makeConstant(1);
+            if (name == "false")
+                return makeConstant(0);
+            if (name == "abs" || name == "sqrt") {
+                expect("(");
+                NodePtr operand = parseOr();
+                expect(")");
+                return makeUnary((name == "abs") ? Op::Abs : Op::Sqrt, std::move(operand));
+            }
+
+            auto it = std::find(m_variables.begin(), m_variables.end(), name);
+            if (it == m_variables.end()) {
+                m_pos = begin;
+                error("unknown variable '" + name + "'");
+            }
+            // Method call syntax of StringCutObjectSelector
+            if (accept("("))
+                expect(")");
+
+            // Variables are numbered in order of first use
+            uint16_t global_index = it - m_variables.begin();
+            auto& used = m_program.m_variables;
+            auto used_it = std::find(used.begin(), used.end(), global_index);
+            if (used_it == used.end())
+                used_it = used.insert(used.end(), global_index);
+
+            NodePtr node(new Node());
+            node->op = Op::Variable;
+            node->index = used_it - used.begin();
+            return node;
+        }
+
+        void emit(const Node& node, size_t& depth, size_t& max_depth) {
+            CutProgram::Instruction instruction = {node.op, false, node.index, node.value};
+            switch (node.op) {
+                case Op::Constant:
+                case Op::Variable:
+                    max_depth = std::max(max_depth, ++depth);
+                    break;
+                case Op::Negate:
+                case Op::Not:
+                case Op::Abs:
+                case Op::Sqrt:
+                    emit(*node.left, depth, max_depth);
+                    break;
+                default:
+                    emit(*node.left, depth, max_depth);
+                    if (node.right->constant()) {
+                        instruction.immediate = true;
+                        instruction.value = node.right->value;
+                    } else {
+                        emit(*node.right, depth, max_depth);
+                        depth--;
+                    }
+                    break;
+            }
+            m_program.m_code.push_back(instruction);
+        }
+
+        const std::string& m_expression;
+        const std::vector<std::string>& m_variables;
+        CutProgram& m_program;
+        size_t m_pos = 0;
+};
+
+CutProgram::CutProgram(const std::string& expression, const std::vector<std::string>& variables) {
+    CutParser(expression, variables, *this).compile();
+}
+
+float CutProgram::evaluate(const float* variables) const {
+    float stack[max_stack_size];
+    size_t top = 0;
+    for (const Instruction& instruction: m_code) {
+        switch (instruction.op) {
+            case Op::Constant:
+                stack[top++] = instruction.value;
+                break;
+            case Op::Variable:
+                stack[top++] = variables[instruction.index];
+                break;
+            case Op::Negate:
+            case Op::Not:
+            case Op::Abs:
+            case Op::Sqrt:
+                stack[top - 1] = unary(instruction.op, stack[top - 1]);
+                break;
+            default: {
+                float right = instruction.immediate ? instruction.value : stack[--top];
+                stack[top - 1] = binary(instruction.op, stack[top - 1], right);
+                break;
+            }
+        }
+    }
+    return stack[0];
+}
+
+#define CUT_VARIABLE(TYPE, NAME, EXPRESSION) {NAME, [](const TYPE& o) -> float { return EXPRESSION; }}
+#define CUT_FIELD(TYPE, FIELD) CUT_VARIABLE(TYPE, #FIELD, o.FIELD)
+#define CUT_P4(TYPE, PREFIX, P4) \
+    CUT_VARIABLE(TYPE, PREFIX "pt", o.P4.Pt()), \
+    CUT_VARIABLE(TYPE, PREFIX "eta", o.P4.Eta()), \
+    CUT_VARIABLE(TYPE, PREFIX "phi", o.P4.Phi()), \
+    CUT_VARIABLE(TYPE, PREFIX "energy", o.P4.E()), \
+    CUT_VARIABLE(TYPE, PREFIX "mass", o.P4.M())
+
+const CutVariables<Lepton>& leptonCutVariables() {
+    static const CutVariables<Lepton> variables = {
+        CUT_P4(Lepton, "", p4),
+        CUT_FIELD(Lepton, charge),
+        CUT_FIELD(Lepton, isMu),
+        CUT_FIELD(Lepton, isEl),
+        CUT_FIELD(Lepton, ele_hlt_id),
+        CUT_FIELD(Lepton, sc_eta),
+        CUT_FIELD(Lepton, gen_matched),
+        CUT_FIELD(Lepton, gen_DR),
+        CUT_FIELD(Lepton, gen_DPtOverPt)
+    };
+    return variables;
+}
+
+const CutVariables<Jet>& jetCutVariables() {
+    static const CutVariables<Jet> variables = {
+        CUT_P4(Jet, "", p4),
+        CUT_FIELD(Jet, CSV),
+        CUT_FIELD(Jet, CMVAv2),
+        CUT_FIELD(Jet, btag_M),
+        CUT_FIELD(Jet, gen_matched_bParton),
+        CUT_FIELD(Jet, gen_matched_bHadron),
+        CUT_FIELD(Jet, gen_matched),
+        CUT_FIELD(Jet, gen_DR),
+        CUT_FIELD(Jet, gen_DPtOverPt),
+        CUT_FIELD(Jet, gen_b),
+        CUT_FIELD(Jet, gen_c),
+        CUT_FIELD(Jet, gen_l)
+    };
+    return variables;
+}
+
+const CutVariables<DileptonMetDijet>& dileptonMetDijetCutVariables() {
+    static const CutVariables<DileptonMetDijet> variables = {
+        CUT_P4(DileptonMetDijet, "", p4),
+        CUT_P4(DileptonMetDijet, "lep1_", lep1_p4),
+        CUT_P4(DileptonMetDijet, "lep2_", lep2_p4),
+        CUT_P4(DileptonMetDijet, "jet1_", jet1_p4),
+        CUT_P4(DileptonMetDijet, "jet2_", jet2_p4),
+        CUT_P4(DileptonMetDijet, "met_", met_p4),
+        CUT_P4(DileptonMetDijet, "ll_", ll_p4),
+        CUT_P4(DileptonMetDijet, "jj_", jj_p4),
+        CUT_P4(DileptonMetDijet, "lljj_", lljj_p4()),
+        CUT_FIELD(DileptonMetDijet, isOS),
+        CUT_FIELD(DileptonMetDijet, isSF),
+        CUT_FIELD(DileptonMetDijet, isElEl),
+        CUT_FIELD(DileptonMetDijet, isElMu),
+        CUT_FIELD(DileptonMetDijet, isMuEl),
+        CUT_FIELD(DileptonMetDijet, isMuMu),
+        CUT_FIELD(DileptonMetDijet, DR_l_l),
+        CUT_FIELD(DileptonMetDijet, DPhi_l_l),
+        CUT_FIELD(DileptonMetDijet, ht_l_l),
+        CUT_FIELD(DileptonMetDijet, isNoHF),
+        CUT_FIELD(DileptonMetDijet, DPhi_ll_met),
+        CUT_FIELD(DileptonMetDijet, minDPhi_l_met),
+        CUT_FIELD(DileptonMetDijet, maxDPhi_l_met),
+        CUT_FIELD(DileptonMetDijet, MT),
+        CUT_FIELD(DileptonMetDijet, MT_formula),
+        CUT_FIELD(DileptonMetDijet, projectedMet),
+        CUT_FIELD(DileptonMetDijet, btag_MM),
+        CUT_FIELD(DileptonMetDijet, sumCSV),
+        CUT_FIELD(DileptonMetDijet, sumCMVAv2),
+        CUT_FIELD(DileptonMetDijet, DR_j_j),
+        CUT_FIELD(DileptonMetDijet, DPhi_j_j),
+        CUT_FIELD(DileptonMetDijet, ht_j_j),
+        CUT_FIELD(DileptonMetDijet, DPhi_jj_met),
+        CUT_FIELD(DileptonMetDijet, minDPhi_j_met),
+        CUT_FIELD(DileptonMetDijet, maxDPhi_j_met),
+        CUT_FIELD(DileptonMetDijet, maxDR_l_j),
+        CUT_FIELD(DileptonMetDijet, minDR_l_j),
+        CUT_FIELD(DileptonMetDijet, DR_ll_jj),
+        CUT_FIELD(DileptonMetDijet, DPhi_ll_jj),
+        CUT_FIELD(DileptonMetDijet, DR_llmet_jj),
+        CUT_FIELD(DileptonMetDijet, DPhi_llmet_jj),
+        CUT_FIELD(DileptonMetDijet, cosThetaStar_CS),
+        CUT_FIELD(DileptonMetDijet, MT_fullsystem),
+        CUT_FIELD(DileptonMetDijet, MT2)
+    };
+    return variables;
+}
+
+}
@@ -0,0 +1,161 @@
+#include <cp3_llbb/HHAnalysis/interface/EtaPhiMatcher.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace HH {
+
+namespace {
+
+    // Bound on the number of cells in eta, for collections spread over a large eta range
+    const size_t max_eta_cells = 64;
+
+    // Squared radius r2 such that, for the squared distances d2 computed in double precision as in DeltaR,
+    // float(sqrt(d2)) < dr is equivalent to d2 < r2: the rounding to float happens at the midpoint between dr and
+    // the float just below, and the square of this midpoint is exact in double precision
+    double coneRadius2(float dr) {
+        if (!(dr > 0))
+            return 0;
+        double r = (double(std::nextafter(dr, 0.f)) + dr) / 2;
+        return r * r;
+    }
+
+    // Same differences as ROOT::Math::VectorUtil::DeltaPhi and DeltaR: single precision, then double precision
+    double distance2(float eta1, float phi1, float eta2, float phi2) {
+        double dphi = phi2 - phi1;
+        if (dphi > M_PI)
+            dphi -= 2 * M_PI;
+        else if (dphi <= -M_PI)
+            dphi += 2 * M_PI;
+        double deta = eta2 - eta1;
+        return dphi * dphi + deta * deta;
+    }
+}
+
+EtaPhiMatcher::EtaPhiMatcher(float cellSize/* = 0.4*/):
+    m_cellSize(cellSize) {
+    m_n_phi = std::max<size_t>(1, std::floor(2 * M_PI / cellSize));
+    m_phi_cell_size = 2 * M_PI / m_n_phi;
+}
+
+void EtaPhiMatcher::build(const std::vector<LorentzVector>& targets) {
+    m_eta.clear();
+    m_phi.clear();
+    for (const auto& p4: targets) {
+        m_eta.push_back(p4.Eta());
+        m_phi.push_back(p4.Phi());
+    }
+    build(m_eta, m_phi);
+}
+
+void EtaPhiMatcher::build(const std::vector<float>& eta, const std::vector<float>& phi) {
+    if (&eta != &m_eta) {
+        m_eta = eta;
+        m_phi = phi;
+    }
+
+    // Eta range of the targets, ignoring the non-finite values which end up in the first or last cell
+    float eta_max = 0;
+    m_eta_min = 0;
+    bool first = true;
+    for (float value: m_eta) {
+        if (!std::isfinite(value))
+            continue;
+        m_eta_min = first ? value : std::min(m_eta_min, value);
+        eta_max = first ? value : std::max(eta_max, value);
+        first = false;
+    }
+    m_eta_cell_size = std::max(m_cellSize, (eta_max - m_eta_min) / (max_eta_cells - 1));
+    m_n_eta = size_t((eta_max - m_eta_min) / m_eta_cell_size) + 1;
+
+    // Counting sort of the targets by cell
+    size_t n_cells = m_n_eta * m_n_phi;
+    m_cell.resize(m_eta.size());
+    m_cell_begin.assign(n_cells + 1, 0);
+    for (size_t i = 0; i < m_eta.size(); i++) {
+        m_cell[i] = etaCell(m_eta[i]) * m_n_phi + phiCell(m_phi[i]);
+        m_cell_begin[m_cell[i] + 1]++;
+    }
+    for (size_t c = 0; c < n_cells; c++)
+        m_cell_begin[c + 1] += m_cell_begin[c];
+    m_sorted.resize(m_eta.size());
+    m_cell_fill.assign(m_cell_begin.begin(), m_cell_begin.end() - 1);
+    for (size_t i = 0; i < m_eta.size(); i++)
+        m_sorted[m_cell_fill[m_cell[i]]++] = i;
+}
+
+size_t EtaPhiMatcher::etaCell(float eta) const {
+    float cell = std::floor((eta - m_eta_min) / m_eta_cell_size);
+    if (!(cell > 0))
+        return 0;
+    return (cell < m_n_eta - 1) ? size_t(cell) : m_n_eta - 1;
+}
+
+size_t EtaPhiMatcher::phiCell(float phi) const {
+    double p = phi + M_PI;
+    p -= 2 * M_PI * std::floor(p / (2 * M_PI));
+    double cell = std::floor(p / m_phi_cell_size);
+    if (!(cell > 0))
+        return 0;
+    return (cell < m_n_phi - 1) ? size_t(cell) : m_n_phi - 1;
+}
+
+template <typename Function>
+void EtaPhiMatcher::visit(float eta, float phi, float dr, Function f) const {
+    if (m_eta.empty())
+        return;
+
+    double r2 = coneRadius2(dr);
+    if (r2 == 0)
+        return;
+
+    // One more cell on each side, for the rounding in the cell computations
+    size_t eta_first = etaCell(eta - dr);
+    eta_first = (eta_first > 0) ? eta_first - 1 : 0;
+    size_t eta_last = std::min(m_n_eta - 1, etaCell(eta + dr) + 1);
+
+    double n_phi_cells = std::ceil(dr / m_phi_cell_size) + 1;
+    bool all_phi = 2 * n_phi_cells + 1 >= m_n_phi;
+    size_t phi_center = phiCell(phi);
+    size_t phi_first = all_phi ? 0 : phi_center + m_n_phi - size_t(n_phi_cells);
+    size_t phi_count = all_phi ? m_n_phi : 2 * size_t(n_phi_cells) + 1;
+
+    for (size_t ieta = eta_first; ieta <= eta_last; ieta++) {
+        for (size_t k = 0; k < phi_count; k++) {
+            size_t c = ieta * m_n_phi + (phi_first + k) % m_n_phi;
+            for (uint32_t j = m_cell_begin[c]; j < m_cell_begin[c + 1]; j++) {
+                uint32_t i = m_sorted[j];
+                double d2 = distance2(eta, phi, m_eta[i], m_phi[i]);
+                if (d2 < r2 && !f(i, d2))
+                    return;
+            }
+        }
+    }
+}
+
+void EtaPhiMatcher::withinCone(float eta, float phi, float dr, std::vector<uint32_t>& matches) const {
+    matches.clear();
+    visit(eta, phi, dr, [&matches](uint32_t i, double) { matches.push_back(i); return true; });
+    std::sort(matches.begin(), matches.end());
+}
+
+bool EtaPhiMatcher::anyWithinCone(float eta, float phi, float dr) const {
+    bool found = false;
+    visit(eta, phi, dr, [&found](uint32_t, double) { found = true; return false; });
+    return found;
+}
+
+int EtaPhiMatcher::nearest(float eta, float phi, float dr/* = std::numeric_limits<float>::max()*/) const {
+    int best = -1;
+    double best_d2 = 0;
+    visit(eta, phi, dr, [&best, &best_d2](uint32_t i, double d2) {
+            if (best < 0 || d2 < best_d2 || (d2 == best_d2 && int(i) < best)) {
+                best = i;
+                best_d2 = d2;
+            }
+            return true;
+        });
+    return best;
+}
+
+}
@@ -0,0 +1,62 @@
+#include <cp3_llbb/HHAnalysis/interface/FastMath.h>
+
+#include <sstream>
+#include <stdexcept>
+
+namespace HH {
+namespace fastmath {
+
+Mode modeFromString(const std::string& mode) {
+    if (mode == "exact")
+        return Mode::Exact;
+    if (mode == "fast")
+        return Mode::Fast;
+    if (mode == "validation")
+        return Mode::Validation;
+
+    throw std::invalid_argument("Unknown kinematics math mode: " + mode);
+}
+
+void Validation::fill(double exact, double fast) {
+    entries++;
+
+    // Identical results, including the same infinity or NaN on both sides
+    if (exact == fast || (std::isnan(exact) && std::isnan(fast))) {
+        counts[0]++;
+        return;
+    }
+
+    // Only one of the results is a NaN or an infinity: no difference to histogram
+    double difference = std::abs(fast - exact);
+    if (!std::isfinite(difference)) {
+        mismatches++;
+        return;
+    }
+
+    if (difference > max_difference) {
+        max_difference = difference;
+        max_difference_exact = exact;
+    }
+
+    // Bin 0 is the underflow (below 1e-9, including no difference), bin n_bins - 1 the overflow (above 1e-1)
+    size_t bin = 0;
+    if (difference >= 1e-9) {
+        int decade = std::floor(std::log10(difference)) + 9;
+        bin = std::min<size_t>(decade + 1, n_bins - 1);
+    }
+    counts[bin]++;
+}
+
+std::string Validation::binLabel(size_t i) {
+    if (i == 0)
+        return "underflow";
+    if (i == n_bins - 1)
+        return "overflow";
+
+    std::ostringstream label;
+    label << "1e" << int(i) - 10;
+    return label.str();
+}
+
+}
+}
@@ -13,6 +13,8 @@
 #include <cp3_llbb/Framework/interface/HLTProducer.h>
 
 #include <cmath>
+#include <numeric>
+#include <stdexcept>
 
 #define HH_GEN_DEBUG (false)
 #define TT_GEN_DEBUG (false)
@@ -20,6 +22,17 @@
 void HHAnalyzer::registerCategories(CategoryManager& manager, const edm::ParameterSet& config) {
     edm::ParameterSet newconfig = edm::ParameterSet(config);
     newconfig.addUntrackedParameter("m_analyzer_name", this->m_name);
+    // Lepton selection, so that the categories can reject events before running the analyzer
+    newconfig.addUntrackedParameter("m_muons_producer", m_muons_producer);
+    newconfig.addUntrackedParameter("m_electrons_producer", m_electrons_producer);
+    newconfig.addUntrackedParameter("m_muonEtaCut", static_cast<double>(m_muonEtaCut));
+    newconfig.addUntrackedParameter("m_muonTightIsoCut", static_cast<double>(m_muonTightIsoCut));
+    newconfig.addUntrackedParameter("m_electronEtaCut", static_cast<double>(m_electronEtaCut));
+    newconfig.addUntrackedParameter("m_electron_medium_wp_name", m_electron_medium_wp_name);
+    newconfig.addUntrackedParameter("m_leadingMuonPtCut", static_cast<double>(m_leadingMuonPtCut));
+    newconfig.addUntrackedParameter("m_subleadingMuonPtCut", static_cast<double>(m_subleadingMuonPtCut));
+    newconfig.addUntrackedParameter("m_leadingElectronPtCut", static_cast<double>(m_leadingElectronPtCut));
+    newconfig.addUntrackedParameter("m_subleadingElectronPtCut", static_cast<double>(m_subleadingElectronPtCut));
     manager.new_category<MuMuCategory>("mumu", "Category with leading leptons as two muons", newconfig);
     manager.new_category<ElElCategory>("elel", "Category with leading leptons as two electrons", newconfig);
     manager.new_category<ElMuCategory>("elmu", "Category with leading leptons as electron, subleading as muon", newconfig);
@@ -32,9 +45,11 @@ void HHAnalyzer::analyze(const edm::Event& event, const edm::EventSetup&, const
     // Reset event
     leptons.clear();
     ll.clear();
+    ll_candidates.clear();
     met.clear();
     llmet.clear();
     jj.clear();
+    llmetjj_candidates.clear();
     //llmetjj.clear();
     //llmetjj_cmva.clear();
 
@@ -47,242 +62,16 @@ void HHAnalyzer::analyze(const edm::Event& event, const edm::EventSetup&, const
 
 
     if (!event.isRealData()) {
+        const GenParticlesProducer& gp = producers.get<GenParticlesProducer>("gen_particles");
 
         // FIXME Moriond 2017
         // BR for taus included in HH sample is not correct (BR is tau -> all instead of tau -> e / mu)
         // If we run over a signal sample, randomly throw events according to BR(tau -> e / mu)
-
-// ***** ***** *****
-// Get the MC truth information on the hard process
-// ***** ***** *****
-// from https://github.com/cms-sw/cmssw/blob/CMSSW_7_4_X/DataFormats/HepMCCandidate/interface/GenStatusFlags.h
-//    enum StatusBits {
-//0      kIsPrompt = 0,
-//1      kIsDecayedLeptonHadron,
-//2      kIsTauDecayProduct,
-//3      kIsPromptTauDecayProduct,
-//4      kIsDirectTauDecayProduct,
-//5      kIsDirectPromptTauDecayProduct,
-//6      kIsDirectHadronDecayProduct,
-//7      kIsHardProcess,
-//8      kFromHardProcess,
-//9      kIsHardProcessTauDecayProduct,
-//10      kIsDirectHardProcessTauDecayProduct,
-//11      kFromHardProcessBeforeFSR,
-//12      kIsFirstCopy,
-//13      kIsLastCopy,
-//14      kIsLastCopyBeforeFSR
-//    };
-
-
-        constexpr double BR_tau_e_mu = 0.3524;
-        size_t n_taus = 0;
-        bool is_signal = false;
-
-        const GenParticlesProducer& gp = producers.get<GenParticlesProducer>("gen_particles");
-
-#if HH_GEN_DEBUG
-    std::function<void(size_t)> print_mother_chain = [&gp, &print_mother_chain](size_t p) {
-
-        if (gp.pruned_mothers_index[p].empty()) {
-            std::cout << std::endl;
+        if (!passTauBRReweighting(fwevent, gp))
             return;
-        }
 
-        size_t index = gp.pruned_mothers_index[p][0];
-            std::cout << " <- #" << index << "(" << gp.pruned_pdg_id[index] << ")";
-            print_mother_chain(index);
-    };
-#endif
-
-        std::function<bool(size_t, size_t)> pruned_decays_from = [&pruned_decays_from, &gp](size_t particle_index, size_t mother_index) -> bool {
-            // Iterator over all pruned particles to find if the particle `particle_index` has `mother_index` in its decay history
-            if (gp.pruned_mothers_index[particle_index].empty())
-                return false;
-
-            size_t index = gp.pruned_mothers_index[particle_index][0];
-
-            if (index == mother_index) {
-                return true;
-            }
-
-            if (pruned_decays_from(index, mother_index))
-                return true;
-
-            return false;
-        };
-
-        std::function<bool(size_t, size_t, bool)> pruned_decays_from_pdg_id = [&pruned_decays_from_pdg_id, &gp](size_t particle_index, uint64_t pdg_id, bool direct) -> bool {
-            // Iterator over all pruned particles to find if the particle `particle_index` decays from a particle with pdg id == pdg_id
-            if (gp.pruned_mothers_index[particle_index].empty())
-                return false;
-
-            size_t index = gp.pruned_mothers_index[particle_index][0];
-
-            if (std::abs(gp.pruned_pdg_id[index]) == pdg_id) {
-                return true;
-            }
-
-            if (!direct && pruned_decays_from_pdg_id(index, pdg_id, direct))
-                return true;
-
-            return false;
-        };
-
-        // Construct signal gen info
-
-        gen_iX = -1;
-        gen_iH1 = gen_iH2 = -1;
-        gen_iH1_afterFSR = gen_iH2_afterFSR = -1;
-        gen_iB = gen_iBbar = -1;
-        gen_iB_afterFSR = gen_iBbar_afterFSR = -1;
-        gen_iV2 = gen_iV1 = -1;
-        gen_iV2_afterFSR = gen_iV1_afterFSR = -1;
-        gen_iLminus = gen_iLplus = -1;
-        gen_iLminus_afterFSR = gen_iLplus_afterFSR = -1;
-        gen_iNu1 = gen_iNu2 = -1;
-
-        for (unsigned int ip = 0; ip < gp.pruned_p4.size(); ip++) {
-            std::bitset<15> flags (gp.pruned_status_flags[ip]);
-
-            if (!flags.test(8))
-                continue;
-
-            int64_t pdg_id = gp.pruned_pdg_id[ip];
-
-#if HH_GEN_DEBUG
-            std::cout << "[" << ip << "] pdg id: " << pdg_id << "  flags: " << flags << "  p = " << gp.pruned_p4[ip] << std::endl;
-            print_mother_chain(ip);
-#endif
-
-            auto p4 = gp.pruned_p4[ip];
-
-            if (std::abs(pdg_id) == 35 || std::abs(pdg_id) == 39) {
-                ASSIGN_HH_GEN_INFO_NO_FSR(X, "X");
-            } else if (pdg_id == 25) {
-                ASSIGN_HH_GEN_INFO_2(H1, H2, "Higgs");
-            }
-
-            // Only look for Higgs decays if we have found the two Higgs
-            if ((gen_iH1 == -1) || (gen_iH2 == -1))
-                continue;
-
-            is_signal = true;
-
-            // And if the particle actually come directly from a Higgs
-            bool from_h1_decay = pruned_decays_from(ip, gen_iH1);
-            bool from_h2_decay = pruned_decays_from(ip, gen_iH2);
-
-            // Only keep particles coming from the Higgs decay
-            if (! from_h1_decay && ! from_h2_decay)
-                continue;
-
-            if (pdg_id == 5) {
-                ASSIGN_HH_GEN_INFO(B, "B");
-            } else if (pdg_id == -5) {
-                ASSIGN_HH_GEN_INFO(Bbar, "Bbar");
-            }
-
-            // Ignore B decays
-            if (pruned_decays_from_pdg_id(ip, 5, false))
-                continue;
-
-            // Count the number of tau coming directly from a W or a Z
-            if ((std::abs(pdg_id) == 15) && (pruned_decays_from_pdg_id(ip, 24, true) || pruned_decays_from_pdg_id(ip, 23, true))) {
-                n_taus++;
-            }
-
-            if ((pdg_id == 11) || (pdg_id == 13) || (pdg_id == 15)) {
-                ASSIGN_HH_GEN_INFO(Lminus, "L-");
-            } else if ((pdg_id == -11) || (pdg_id == -13) || (pdg_id == -15)) {
-                ASSIGN_HH_GEN_INFO(Lplus, "L+");
-            } else if ((pdg_id == 23) || (std::abs(pdg_id) == 24)) {
-                ASSIGN_HH_GEN_INFO_2(V1, V2, "W/Z bosons");
-            } else if ((std::abs(pdg_id) == 12) || (std::abs(pdg_id) == 14) || (std::abs(pdg_id) == 16)) {
-                ASSIGN_HH_GEN_INFO_2_NO_FSR(Nu1, Nu2, "neutrinos");
-            }
-        }
-
-        if (is_signal) {
-            // FIXME Moriond 2017
-            if (n_taus > 2) {
-                std::cout << "ERROR: More than two taus coming from Higgs decays. There's something wrong!" << std::endl;
-            }
-
-            double factor = std::pow(BR_tau_e_mu, n_taus);
-            if (br_generator(random_generator) > factor) {
-                return;
-            }
-        }
-
-        // Swap neutrinos if needed
-        if ((gen_iNu1 != -1) && (gen_iNu2 != -1)) {
-            if (gp.pruned_pdg_id[gen_iNu1] > 0) {
-                std::swap(gen_iNu1, gen_iNu2);
-                std::swap(gen_Nu1, gen_Nu2);
-            }
-        }
-
-        if ((gen_iH1 != -1) && (gen_iH2 != -1)) {
-            gen_mHH = (gen_H1 + gen_H2).M();
-            gen_costhetastar = getCosThetaStar_CS(gen_H1, gen_H2);
-        }
-
-#if HH_GEN_DEBUG
-        PRINT_PARTICULE(X);
-        PRINT_RESONANCE(H1, H2);
-        PRINT_RESONANCE(B, Bbar);
-        PRINT_RESONANCE(V1, V2);
-        PRINT_RESONANCE(Lminus, Lplus);
-        PRINT_RESONANCE_NO_FSR(Nu1, Nu2);
-
-        // Rebuild resonances for consistency checks
-        auto LminusNu1 = gen_Lminus + gen_Nu1;
-        std::cout << "    gen_(L- Nu1).M() = " << LminusNu1.M() << std::endl;
-
-        auto LplusNu2 = gen_Lplus + gen_Nu2;
-        std::cout << "    gen_(L+ Nu2).M() = " << LplusNu2.M() << std::endl;
-
-        auto LminusNu1_afterFSR = gen_Lminus_afterFSR + gen_Nu1;
-        std::cout << "    gen_(L- Nu1)_afterFSR.M() = " << LminusNu1_afterFSR.M() << std::endl;
-
-        auto LplusNu2_afterFSR = gen_Lplus_afterFSR + gen_Nu2;
-        std::cout << "    gen_(L+ Nu2)_afterFSR.M() = " << LplusNu2_afterFSR.M() << std::endl;
-        
-        auto LLNuNu = gen_Lplus + gen_Lminus + gen_Nu1 + gen_Nu2;
-        std::cout << "    gen_(LL NuNu).M() = " << LLNuNu.M() << std::endl;
-
-        auto LLNuNu_afterFSR = gen_Lplus_afterFSR + gen_Lminus_afterFSR + gen_Nu1 + gen_Nu2;
-        std::cout << "    gen_(LL NuNu)_afterFSR.M() = " << LLNuNu_afterFSR.M() << std::endl;
-
-        auto LLNuNuBB = gen_Lplus + gen_Lminus + gen_Nu1 + gen_Nu2 + gen_B + gen_Bbar;
-        std::cout << "    gen_(LL NuNu BB).M() = " << LLNuNuBB.M() << std::endl;
-
-        auto LLNuNuBB_afterFSR = gen_Lplus_afterFSR + gen_Lminus_afterFSR + gen_Nu1 + gen_Nu2 + gen_B_afterFSR + gen_Bbar_afterFSR;
-        std::cout << "    gen_(LL NuNu BB)_afterFSR.M() = " << LLNuNuBB_afterFSR.M() << std::endl;
-#endif
-
-        // ***** ***** *****
-        // Matching
-        // ***** ***** *****
-        for (auto p4: alljets.gen_p4) {
-            gen_deltaR_jet_B.push_back(deltaR(p4, gen_B));
-            gen_deltaR_jet_Bbar.push_back(deltaR(p4, gen_Bbar));
-            gen_deltaR_jet_B_afterFSR.push_back(deltaR(p4, gen_B_afterFSR));
-            gen_deltaR_jet_Bbar_afterFSR.push_back(deltaR(p4, gen_Bbar_afterFSR));
-        }
-        for (auto p4: allelectrons.gen_p4) {
-            gen_deltaR_electron_L1.push_back(deltaR(p4, gen_Lminus));
-            gen_deltaR_electron_L2.push_back(deltaR(p4, gen_Lplus));
-            gen_deltaR_electron_L1_afterFSR.push_back(deltaR(p4, gen_Lminus_afterFSR));
-            gen_deltaR_electron_L2_afterFSR.push_back(deltaR(p4, gen_Lplus_afterFSR));
-        }
-        for (auto p4: allmuons.gen_p4) {
-            gen_deltaR_muon_L1.push_back(deltaR(p4, gen_Lminus));
-            gen_deltaR_muon_L2.push_back(deltaR(p4, gen_Lplus));
-            gen_deltaR_muon_L1_afterFSR.push_back(deltaR(p4, gen_Lminus_afterFSR));
-            gen_deltaR_muon_L2_afterFSR.push_back(deltaR(p4, gen_Lplus_afterFSR));
-        }
+        if (!m_genTruthAfterRecoSelection)
+            fillHHGenInfo(gp, alljets, allelectrons, allmuons);
     }
 
     //float mh = event.isRealData() ? 125.09 : 125.0;
@@ -333,177 +122,158 @@ void HHAnalyzer::analyze(const edm::Event& event, const edm::EventSetup&, const
         return result;
     };
 
-    // Fill lepton structures
-    for (unsigned int ielectron = 0; ielectron < allelectrons.p4.size(); ielectron++)
-    {
-        if (allelectrons.p4[ielectron].Pt() > m_subleadingElectronPtCut
-            && fabs(allelectrons.p4[ielectron].Eta()) < m_electronEtaCut) 
-        {
-            // some selection
-            // Ask for medium ID
-            if (!allelectrons.ids[ielectron][m_electron_medium_wp_name])
-                continue;
+    // Fill lepton structures. The kinematic cuts (and the muon ID and isolation) are first evaluated on the producer columns,
+    // only the objects passing them are looked at
+    preselection.reset(allelectrons.p4.size()).kinematics(allelectrons.p4, m_subleadingElectronPtCut, m_electronEtaCut);
+    preselection.mask().forEach([&](unsigned int ielectron) {
+        // some selection
+        // Ask for medium ID
+        if (!allelectrons.ids[ielectron][m_electron_medium_wp_name])
+            return;
 
-            HH::Lepton ele;
-            ele.p4 = allelectrons.p4[ielectron];
-            ele.charge = allelectrons.charge[ielectron];
-            ele.idx = ielectron;
-            ele.isMu = false;
-            ele.isEl = true;
-            ele.ele_hlt_id = electron_pass_HLT_ID(ielectron);
+        HH::Lepton ele;
+        ele.p4 = allelectrons.p4[ielectron];
+        ele.charge = allelectrons.charge[ielectron];
+        ele.idx = ielectron;
+        ele.isMu = false;
+        ele.isEl = true;
+        ele.ele_hlt_id = electron_pass_HLT_ID(ielectron);
 
-            ele.gen_matched = allelectrons.matched[ielectron];
-            ele.gen_p4 = ele.gen_matched ? allelectrons.gen_p4[ielectron] : null_p4;
-            ele.gen_DR = ele.gen_matched ? ROOT::Math::VectorUtil::DeltaR(ele.p4, ele.gen_p4): -1.;
-            ele.gen_DPtOverPt = ele.gen_matched ? (ele.p4.Pt() - ele.gen_p4.Pt()) / ele.p4.Pt() : -10.;
-            ele.hlt_leg1 = false;
-            ele.hlt_leg2 = false;
+        ele.gen_matched = allelectrons.matched[ielectron];
+        ele.gen_p4 = ele.gen_matched ? allelectrons.gen_p4[ielectron] : null_p4;
+        ele.gen_DR = ele.gen_matched ? ROOT::Math::VectorUtil::DeltaR(ele.p4, ele.gen_p4): -1.;
+        ele.gen_DPtOverPt = ele.gen_matched ? (ele.p4.Pt() - ele.gen_p4.Pt()) / ele.p4.Pt() : -10.;
+        ele.hlt_leg1 = false;
+        ele.hlt_leg2 = false;
 
-            ele.sc_eta = allelectrons.products[ielectron]->superCluster()->eta();
+        ele.sc_eta = allelectrons.products[ielectron]->superCluster()->eta();
 
-            leptons.push_back(ele);
-        }
-    }//end of loop on electrons
+        if (!m_leptonCut(ele))
+            return;
 
-    for (unsigned int imuon = 0; imuon < allmuons.p4.size(); imuon++)
-    {
-        if (allmuons.p4[imuon].Pt() > m_subleadingMuonPtCut
-            && fabs(allmuons.p4[imuon].Eta()) < m_muonEtaCut)
-        {
-            // Ask for tight ID & tight ISO
-            if (!allmuons.isTight[imuon] || allmuons.relativeIsoR04_deltaBeta[imuon] >= m_muonTightIsoCut)
-                continue;
+        leptons.push_back(ele);
+    });//end of loop on electrons
+
+    // Ask for tight ID & tight ISO
+    preselection.reset(allmuons.p4.size()).kinematics(allmuons.p4, m_subleadingMuonPtCut, m_muonEtaCut).flag(allmuons.isTight).below(allmuons.relativeIsoR04_deltaBeta, m_muonTightIsoCut);
+    preselection.mask().forEach([&](unsigned int imuon) {
+        HH::Lepton mu;
+        mu.p4 = allmuons.p4[imuon];
+        mu.charge = allmuons.charge[imuon];
+        mu.idx = imuon;
+        mu.isMu = true;
+        mu.isEl = false;
+        mu.gen_matched = allmuons.matched[imuon];
+        mu.gen_p4 = mu.gen_matched ? allmuons.gen_p4[imuon] : null_p4;
+        mu.gen_DR = mu.gen_matched ? ROOT::Math::VectorUtil::DeltaR(mu.p4, mu.gen_p4) : -1.;
+        mu.gen_DPtOverPt = mu.gen_matched ? (mu.p4.Pt() - mu.gen_p4.Pt()) / mu.p4.Pt() : -10.;
+        mu.hlt_leg1 = false;
+        mu.hlt_leg2 = false;
+        fillL1TGeometry(mu);
+
+        if (!m_leptonCut(mu))
+            return;
 
-            HH::Lepton mu;
-            mu.p4 = allmuons.p4[imuon];
-            mu.charge = allmuons.charge[imuon];
-            mu.idx = imuon;
-            mu.isMu = true;
-            mu.isEl = false;
-            mu.gen_matched = allmuons.matched[imuon];
-            mu.gen_p4 = mu.gen_matched ? allmuons.gen_p4[imuon] : null_p4;
-            mu.gen_DR = mu.gen_matched ? ROOT::Math::VectorUtil::DeltaR(mu.p4, mu.gen_p4) : -1.;
-            mu.gen_DPtOverPt = mu.gen_matched ? (mu.p4.Pt() - mu.gen_p4.Pt()) / mu.p4.Pt() : -10.;
-            mu.hlt_leg1 = false;
-            mu.hlt_leg2 = false;
-
-            leptons.push_back(mu);
-        }
-    }//end of loop on muons
+        leptons.push_back(mu);
+    });//end of loop on muons
 
     // sort leptons by pt (ignoring flavour, id and iso)
     std::sort(leptons.begin(), leptons.end(), [](const HH::Lepton& lep1, const HH::Lepton& lep2) { return lep1.p4.Pt() > lep2.p4.Pt(); });
 
-    for (unsigned int ilep1 = 0; ilep1 < leptons.size(); ilep1++)
+    // Pairwise lepton kinematics, computed at once for all the pairs
+    leptons_soa.clear();
+    for (const auto& lepton: leptons)
+        leptons_soa.push_back(lepton.p4);
+    HH::computeDeltaPhiDeltaR(leptons_soa, leptons_soa, ll_DPhi, ll_DR);
+
+    // Only opposite-sign pairs are considered: bucket the leptons by charge
+    // Leptons are sorted by pt, so the lepton with the lowest index is the leading one
+    positive_leptons.clear();
+    negative_leptons.clear();
+    for (unsigned int ilep = 0; ilep < leptons.size(); ilep++) {
+        if (leptons[ilep].charge > 0)
+            positive_leptons.push_back(ilep);
+        else if (leptons[ilep].charge < 0)
+            negative_leptons.push_back(ilep);
+    }
+
+    for (unsigned int ilep_plus: positive_leptons) {
+        for (unsigned int ilep_minus: negative_leptons) {
+            HH::DileptonCandidate candidate;
+            candidate.ilep1 = std::min(ilep_plus, ilep_minus);
+            candidate.ilep2 = std::max(ilep_plus, ilep_minus);
+            if ((leptons[candidate.ilep1].isMu && leptons[candidate.ilep1].p4.Pt() < m_leadingMuonPtCut) || (leptons[candidate.ilep1].isEl && leptons[candidate.ilep1].p4.Pt() < m_leadingElectronPtCut)) continue;
+            candidate.ht_l_l = leptons[candidate.ilep1].p4.Pt() + leptons[candidate.ilep2].p4.Pt();
+            ll_candidates.push_back(candidate);
+        }
+    }
+
+    // have the dilepton candidates sorted by ht
+    std::sort(ll_candidates.begin(), ll_candidates.end(), [&](HH::DileptonCandidate& a, HH::DileptonCandidate& b){return a.ht_l_l > b.ht_l_l;});
+
+    // HLT matching and trigger efficiencies are only evaluated for the candidates being tried, in ht order,
+    // and only the first one passing the selection is kept
+    if (!ll_candidates.empty() && !hlt.paths.empty()) {
+        hlt_matcher.build(hlt.object_p4);
+        hlt_flags.build(hlt.object_paths, hlt.object_filters);
+        hlt_lepton_objects.resize(leptons.size());
+        hlt_lepton_objects_cached.assign(leptons.size(), false);
+    }
+    for (const auto& candidate: ll_candidates)
     {
-        if ((leptons[ilep1].isMu && leptons[ilep1].p4.Pt() < m_leadingMuonPtCut) || (leptons[ilep1].isEl && leptons[ilep1].p4.Pt() < m_leadingElectronPtCut)) continue;
+        unsigned int ilep1 = candidate.ilep1;
+        unsigned int ilep2 = candidate.ilep2;
 
-        for (unsigned int ilep2 = ilep1+1; ilep2 < leptons.size(); ilep2++)
-        {
-            HH::Dilepton dilep;
-            dilep.p4 = leptons[ilep1].p4 + leptons[ilep2].p4;
-            dilep.idxs = std::make_pair(leptons[ilep1].idx, leptons[ilep2].idx);
-            dilep.ilep1 = ilep1;
-            dilep.ilep2 = ilep2;
-            dilep.isOS = leptons[ilep1].charge * leptons[ilep2].charge < 0;
-            dilep.isPlusMinus = leptons[ilep1].charge > 0 && leptons[ilep2].charge < 0;
-            dilep.isMinusPlus = leptons[ilep1].charge < 0 && leptons[ilep2].charge > 0;
-            dilep.isMuMu = leptons[ilep1].isMu && leptons[ilep2].isMu;
-            dilep.isElEl = leptons[ilep1].isEl && leptons[ilep2].isEl;
-            dilep.isElMu = leptons[ilep1].isEl && leptons[ilep2].isMu;
-            dilep.isMuEl = leptons[ilep1].isMu && leptons[ilep2].isEl;
-            dilep.isSF = dilep.isMuMu || dilep.isElEl;
-            //dilep.id_LL = leptons[ilep1].id_L && leptons[ilep2].id_L;
-            //dilep.id_LM = (leptons[ilep1].id_L && leptons[ilep2].id_M) || (leptons[ilep2].id_L && leptons[ilep1].id_M);
-            //dilep.id_LT = (leptons[ilep1].id_L && leptons[ilep2].id_T) || (leptons[ilep2].id_L && leptons[ilep1].id_T);
-            //dilep.id_LHWW = (leptons[ilep1].id_L && leptons[ilep2].id_HWW) || (leptons[ilep2].id_L && leptons[ilep1].id_HWW);
-            //dilep.id_ML = (leptons[ilep1].id_M && leptons[ilep2].id_L) || (leptons[ilep2].id_M && leptons[ilep1].id_L);
-            //dilep.id_MM = leptons[ilep1].id_M && leptons[ilep2].id_M;
-            //dilep.id_MT = (leptons[ilep1].id_T && leptons[ilep2].id_M) || (leptons[ilep2].id_T && leptons[ilep1].id_M);
-            //dilep.id_MHWW = (leptons[ilep1].id_M && leptons[ilep2].id_HWW) || (leptons[ilep2].id_M && leptons[ilep1].id_HWW);
-            //dilep.id_TL = (leptons[ilep1].id_T && leptons[ilep2].id_L) || (leptons[ilep2].id_T && leptons[ilep1].id_L);
-            //dilep.id_TM = (leptons[ilep1].id_T && leptons[ilep2].id_M) || (leptons[ilep2].id_T && leptons[ilep1].id_M);
-            //dilep.id_TT = leptons[ilep1].id_T && leptons[ilep2].id_T;
-            //dilep.id_THWW = (leptons[ilep1].id_T && leptons[ilep2].id_HWW) || (leptons[ilep2].id_T && leptons[ilep1].id_HWW);
-            //dilep.id_HWWL = (leptons[ilep1].id_HWW && leptons[ilep2].id_L) || (leptons[ilep2].id_HWW && leptons[ilep1].id_L);
-            //dilep.id_HWWM = (leptons[ilep1].id_HWW && leptons[ilep2].id_M) || (leptons[ilep2].id_HWW && leptons[ilep1].id_M);
-            //dilep.id_HWWT = (leptons[ilep1].id_HWW && leptons[ilep2].id_T) || (leptons[ilep2].id_HWW && leptons[ilep1].id_T);
-            //dilep.id_HWWHWW = leptons[ilep1].id_HWW && leptons[ilep2].id_HWW;
-            //dilep.iso_LL = leptons[ilep1].iso_L && leptons[ilep2].iso_L;
-            //dilep.iso_LT = (leptons[ilep1].iso_L && leptons[ilep2].iso_T) || (leptons[ilep2].iso_L && leptons[ilep1].iso_T);
-            //dilep.iso_LHWW = (leptons[ilep1].iso_L && leptons[ilep2].iso_HWW) || (leptons[ilep2].iso_L && leptons[ilep1].iso_HWW);
-            //dilep.iso_TL = (leptons[ilep1].iso_T && leptons[ilep2].iso_L) || (leptons[ilep2].iso_T && leptons[ilep1].iso_L);
-            //dilep.iso_TT = leptons[ilep1].iso_T && leptons[ilep2].iso_T;
-            //dilep.iso_THWW = (leptons[ilep1].iso_T && leptons[ilep2].iso_HWW) || (leptons[ilep2].iso_T && leptons[ilep1].iso_HWW);
-            //dilep.iso_HWWL = (leptons[ilep1].iso_HWW && leptons[ilep2].iso_L) || (leptons[ilep2].iso_HWW && leptons[ilep1].iso_L);
-            //dilep.iso_HWWT = (leptons[ilep1].iso_HWW && leptons[ilep2].iso_T) || (leptons[ilep2].iso_HWW && leptons[ilep1].iso_T);
-            //dilep.iso_HWWHWW = leptons[ilep1].iso_HWW && leptons[ilep2].iso_HWW;
-            dilep.DR_l_l = ROOT::Math::VectorUtil::DeltaR(leptons[ilep1].p4, leptons[ilep2].p4);
-            dilep.DPhi_l_l = fabs(ROOT::Math::VectorUtil::DeltaPhi(leptons[ilep1].p4, leptons[ilep2].p4));
-            dilep.ht_l_l = leptons[ilep1].p4.Pt() + leptons[ilep2].p4.Pt();
-            if (!hlt.paths.empty()) {
-                matchOfflineLepton(hlt, dilep);
-                dilep.hlt_idxs = std::make_pair(leptons[dilep.ilep1].hlt_idx, leptons[dilep.ilep2].hlt_idx);
-            }
-            dilep.gen_matched = leptons[ilep1].gen_matched && leptons[ilep2].gen_matched;
-            dilep.gen_p4 = dilep.gen_matched ? leptons[ilep1].gen_p4 + leptons[ilep2].gen_p4 : null_p4;
-            dilep.gen_DR = dilep.gen_matched ? ROOT::Math::VectorUtil::DeltaR(dilep.p4, dilep.gen_p4) : -1.;
-            dilep.gen_DPtOverPt = dilep.gen_matched ? (dilep.p4.Pt() - dilep.gen_p4.Pt()) / dilep.p4.Pt() : -10.;
-
-            if (event.isRealData()) {
-               dilep.trigger_efficiency = 1.;
-               dilep.trigger_efficiency_downVariated = 1.;
-               dilep.trigger_efficiency_upVariated = 1.;
-            } else {
-               fillTriggerEfficiencies(leptons[ilep1], leptons[ilep2], dilep);
-            }
-            // Some selection
-            // Note that ID and isolation criteria are in both electron and muon loops
-            if (!dilep.isOS)
-                continue;
+        // FIXME L1 EMTF bug mitigation -- cut the overlap on data if it's a run affected by the bug
+        // On MC, apply the fraction of lumi the bug was not present
+        bool isInCSCOverlap = leptons[ilep1].isMu && leptons[ilep2].isMu && isCSCWithOverlap(leptons[ilep1], leptons[ilep2]);
+        if (isInCSCOverlap && event.isRealData() && fwevent.run < 278167)
+            continue;
 
-            // FIXME L1 EMTF bug mitigation -- cut the overlap on data if it's a run affected by the bug
-            // On MC, apply the fraction of lumi the bug was not present
-            if (dilep.isMuMu && isCSCWithOverlap(leptons[ilep1], leptons[ilep2])) {
-                if (event.isRealData() && fwevent.run < 278167) {
-                    continue;
-                } else if (!event.isRealData()) {
-                   dilep.trigger_efficiency *= 0.5265;
-                   dilep.trigger_efficiency_downVariated *= 0.5265;
-                   dilep.trigger_efficiency_upVariated *= 0.5265;
-                }
-            }
+        HH::Dilepton dilep = makeDilepton(ilep1, ilep2);
+        if (!hlt.paths.empty()) {
+            matchOfflineLepton(hlt, dilep);
+            dilep.hlt_idxs = std::make_pair(leptons[dilep.ilep1].hlt_idx, leptons[dilep.ilep2].hlt_idx);
+        }
 
+        if (event.isRealData()) {
             // Throw event if there is no matched dilepton trigger path (only on data)
-            if (event.isRealData()
-                && !((leptons[dilep.ilep1].hlt_leg1 && leptons[dilep.ilep2].hlt_leg2)
+            if (!((leptons[dilep.ilep1].hlt_leg1 && leptons[dilep.ilep2].hlt_leg2)
                 || (leptons[dilep.ilep1].hlt_leg2 && leptons[dilep.ilep2].hlt_leg1))) {
                 continue;
             }
-
-            // Counters
-            tmp_count_has2leptons = event_weight;
-            if (dilep.isElEl)
-                tmp_count_has2leptons_elel = event_weight;
-            if (dilep.isElMu)
-                tmp_count_has2leptons_elmu = event_weight;
-            if (dilep.isMuEl)
-                tmp_count_has2leptons_muel = event_weight;
-            if (dilep.isMuMu)
-                tmp_count_has2leptons_mumu = event_weight;
-
-            // Fill
-            ll.push_back(dilep); 
+            dilep.trigger_efficiency = 1.;
+            dilep.trigger_efficiency_downVariated = 1.;
+            dilep.trigger_efficiency_upVariated = 1.;
+        } else {
+            fillTriggerEfficiencies(leptons[ilep1], leptons[ilep2], dilep);
+            if (isInCSCOverlap) {
+                dilep.trigger_efficiency *= 0.5265;
+                dilep.trigger_efficiency_downVariated *= 0.5265;
+                dilep.trigger_efficiency_upVariated *= 0.5265;
+            }
         }
-    }
-    // have the ll collection sorted by ht
-    std::sort(ll.begin(), ll.end(), [&](HH::Dilepton& a, HH::Dilepton& b){return a.ht_l_l > b.ht_l_l;});
 
-    // Keep only the first ll candidate
-    if (ll.size() > 1) {
-        ll.resize(1);
+        // Counters
+        tmp_count_has2leptons = event_weight;
+        if (dilep.isElEl)
+            tmp_count_has2leptons_elel = event_weight;
+        if (dilep.isElMu)
+            tmp_count_has2leptons_elmu = event_weight;
+        if (dilep.isMuEl)
+            tmp_count_has2leptons_muel = event_weight;
+        if (dilep.isMuMu)
+            tmp_count_has2leptons_mumu = event_weight;
+
+        // Fill, and keep only the first ll candidate
+        ll.push_back(dilep);
+        break;
     }
 
+    // Gen-truth for the hard process, only for events with a selected dilepton in reco-first mode
+    if (!event.isRealData() && m_genTruthAfterRecoSelection && !ll.empty())
+        fillHHGenInfo(producers.get<GenParticlesProducer>("gen_particles"), alljets, allelectrons, allmuons);
+
     // ***** 
     // Adding MET(s)
     // ***** 
@@ -541,61 +311,17 @@ void HHAnalyzer::analyze(const edm::Event& event, const edm::EventSetup&, const
     {
         for (unsigned int ill = 0; ill < ll.size(); ill++)
         {
-            HH::DileptonMet myllmet;
-// DileptonMet inherits from Dilepton struct, initalize everything properly
-// FIXME: there is very probably a cleaner way to do
-            myllmet.p4 = ll[ill].p4 + met[imet].p4;
-            // blind copy of the ll content
-            myllmet.idxs = std::make_pair(ll[ill].idxs.first, ll[ill].idxs.second);
-            myllmet.ilep1 = ll[ill].ilep1;
-            myllmet.ilep2 = ll[ill].ilep2;
-            myllmet.isOS = ll[ill].isOS;
-            myllmet.isPlusMinus = ll[ill].isPlusMinus;
-            myllmet.isMinusPlus = ll[ill].isMinusPlus;
-            myllmet.isMuMu = ll[ill].isMuMu;
-            myllmet.isElEl = ll[ill].isElEl;
-            myllmet.isElMu = ll[ill].isElMu;
-            myllmet.isMuEl = ll[ill].isMuEl;
-            myllmet.isSF = ll[ill].isSF;
-            //myllmet.id_LL = ll[ill].id_LL;
-            //myllmet.id_LM = ll[ill].id_LM;
-            //myllmet.id_LT = ll[ill].id_LT;
-            //myllmet.id_LHWW = ll[ill].id_LHWW;
-            //myllmet.id_ML = ll[ill].id_ML;
-            //myllmet.id_MM = ll[ill].id_MM;
-            //myllmet.id_MT = ll[ill].id_MT;
-            //myllmet.id_MHWW = ll[ill].id_MHWW;
-            //myllmet.id_TL = ll[ill].id_TL;
-            //myllmet.id_TM = ll[ill].id_TM;
-            //myllmet.id_TT = ll[ill].id_TT;
-            //myllmet.id_THWW = ll[ill].id_THWW;
-            //myllmet.id_HWWL = ll[ill].id_HWWL;
-            //myllmet.id_HWWM = ll[ill].id_HWWM;
-            //myllmet.id_HWWT = ll[ill].id_HWWT;
-            //myllmet.id_HWWHWW = ll[ill].id_HWWHWW;
-            //myllmet.iso_LL = ll[ill].iso_LL;
-            //myllmet.iso_LT = ll[ill].iso_LT;
-            //myllmet.iso_LHWW = ll[ill].iso_LHWW;
-            //myllmet.iso_TL = ll[ill].iso_TL;
-            //myllmet.iso_TT = ll[ill].iso_TT;
-            //myllmet.iso_THWW = ll[ill].iso_THWW;
-            //myllmet.iso_HWWL = ll[ill].iso_HWWL;
-            //myllmet.iso_HWWT = ll[ill].iso_HWWT;
-            //myllmet.iso_HWWHWW = ll[ill].iso_HWWHWW;
-            myllmet.DR_l_l = ll[ill].DR_l_l;
-            myllmet.DPhi_l_l = ll[ill].DPhi_l_l;
-            myllmet.ht_l_l = ll[ill].ht_l_l;
-            // content specific to HH:DileptonMet
+            HH::DileptonMetCandidate myllmet;
             myllmet.ill = ill;
             myllmet.imet = imet;
-            myllmet.isNoHF = met[imet].isNoHF;
+            myllmet.p4 = ll[ill].p4 + met[imet].p4;
             float dphi = fabs(ROOT::Math::VectorUtil::DeltaPhi(ll[ill].p4, met[imet].p4));
             myllmet.DPhi_ll_met = dphi;
             float mindphi = std::min(fabs(ROOT::Math::VectorUtil::DeltaPhi(leptons[ll[ill].ilep1].p4, met[imet].p4)), fabs(ROOT::Math::VectorUtil::DeltaPhi(leptons[ll[ill].ilep2].p4, met[imet].p4)));
             myllmet.minDPhi_l_met = mindphi; 
             float maxdphi = std::max(fabs(ROOT::Math::VectorUtil::DeltaPhi(leptons[ll[ill].ilep1].p4, met[imet].p4)), fabs(ROOT::Math::VectorUtil::DeltaPhi(leptons[ll[ill].ilep2].p4, met[imet].p4)));
             myllmet.maxDPhi_l_met = maxdphi;
-            myllmet.MT = (ll[ill].p4 + met[imet].p4).M();
+            myllmet.MT = myllmet.p4.M();
             myllmet.MT_formula = std::sqrt(2 * ll[ill].p4.Pt() * met[imet].p4.Pt() * (1-std::cos(dphi)));
             myllmet.projectedMet = mindphi >= M_PI ? met[imet].p4.Pt() : met[imet].p4.Pt() * std::sin(mindphi);
             myllmet.gen_matched = ll[ill].gen_matched && met[imet].gen_matched;
@@ -611,290 +337,225 @@ void HHAnalyzer::analyze(const edm::Event& event, const edm::EventSetup&, const
     // Jets and dijets 
     // ***** 
 
-    for (unsigned int ijet = 0; ijet < alljets.p4.size(); ijet++)
+    // Jets passing the kinematic and ID cuts, before the cleaning against the selected leptons
+    jet_candidates.clear();
+    jets_soa.clear();
+    jet_correction_factors.clear();
+    if (m_applyBJetRegression) {
+        for (unsigned int ijet = 0; ijet < alljets.p4.size(); ijet++)
+            jet_correction_factors.push_back(alljets.regPt[ijet] / alljets.p4[ijet].Pt());
+    }
+    preselection.reset(alljets.p4.size()).kinematics(alljets.p4, m_jetPtCut, m_jetEtaCut, m_applyBJetRegression ? &jet_correction_factors : nullptr).flag(alljets.passLooseID);
+    preselection.mask().forEach([&](unsigned int ijet) {
+        float correctionFactor = m_applyBJetRegression ? jet_correction_factors[ijet] : 1.;
+        jet_candidates.push_back(std::make_pair(ijet, correctionFactor));
+        jets_soa.push_back(alljets.p4[ijet] * correctionFactor);
+    });
+
+    // Jet-lepton cleaning, looking for the leptons in the eta-phi grid
+    lepton_matcher.build(leptons_soa.eta, leptons_soa.phi);
+    for (unsigned int icandidate = 0; icandidate < jet_candidates.size(); icandidate++)
     {
-        float correctionFactor = m_applyBJetRegression ? alljets.regPt[ijet] / alljets.p4[ijet].Pt() : 1.;
-/*
-        std::cout << "m_jets_producer= " << m_jets_producer
-            << "\tm_applyBJetRegression= " << m_applyBJetRegression
-            << "\talljets.p4[" << ijet << "].Pt()= " << alljets.p4[ijet].Pt()
-            << "\talljets.regPt[" << ijet << "]= " << alljets.regPt[ijet]
-            << "\tcorrectionFactor= " << correctionFactor
-            << std::endl;
-*/
-        if ((alljets.p4[ijet].Pt() * correctionFactor > m_jetPtCut) 
-            && (fabs(alljets.p4[ijet].Eta()) < m_jetEtaCut))
-        {
+        unsigned int ijet = jet_candidates[icandidate].first;
+        float correctionFactor = jet_candidates[icandidate].second;
 
-            if (!alljets.passLooseID[ijet])
-                continue;
+        bool isThereACloseSelectedLepton = lepton_matcher.anyWithinCone(jets_soa.eta[icandidate], jets_soa.phi[icandidate], m_minDR_l_j_Cut);
+        if (isThereACloseSelectedLepton)
+            continue;
 
-            HH::Jet myjet;
-            myjet.p4 = alljets.p4[ijet] * correctionFactor;
-            myjet.idx = ijet;
-
-            myjet.CSV = alljets.getBTagDiscriminant(ijet, "pfCombinedInclusiveSecondaryVertexV2BJetTags");
-            myjet.CMVAv2 = alljets.getBTagDiscriminant(ijet, "pfCombinedMVAV2BJetTags");
-            float mybtag = alljets.getBTagDiscriminant(ijet, m_jet_bDiscrName);
-            //myjet.btag_L = mybtag > m_jet_bDiscrCut_loose;
-            myjet.btag_M = mybtag > m_jet_bDiscrCut_medium;
-            //myjet.btag_T = mybtag > m_jet_bDiscrCut_tight;
-            myjet.gen_matched_bParton = (std::abs(alljets.partonFlavor[ijet]) == 5);
-            myjet.gen_matched_bHadron = (alljets.hadronFlavor[ijet]) == 5;
-            myjet.gen_matched = alljets.matched[ijet];
-            myjet.gen_p4 = myjet.gen_matched ? alljets.gen_p4[ijet] : null_p4;
-            myjet.gen_DR = myjet.gen_matched ? ROOT::Math::VectorUtil::DeltaR(myjet.p4, myjet.gen_p4) : -1.;
-            myjet.gen_DPtOverPt = myjet.gen_matched ? (myjet.p4.Pt() - myjet.gen_p4.Pt()) / myjet.p4.Pt() : -10.;
-            myjet.gen_b = (alljets.hadronFlavor[ijet]) == 5; // redundant with gen_matched_bHadron defined above
-            myjet.gen_c = (alljets.hadronFlavor[ijet]) == 4;
-            myjet.gen_l = (alljets.hadronFlavor[ijet]) < 4;
-
-            bool isThereACloseSelectedLepton = false;
-            for (auto& mylepton: leptons) {
-                if (ROOT::Math::VectorUtil::DeltaR(myjet.p4, mylepton.p4) < m_minDR_l_j_Cut) {
-                    isThereACloseSelectedLepton = true;
-                    break;
-                }
-            }
+        HH::Jet myjet;
+        myjet.p4 = alljets.p4[ijet] * correctionFactor;
+        myjet.idx = ijet;
+
+        myjet.CSV = alljets.getBTagDiscriminant(ijet, "pfCombinedInclusiveSecondaryVertexV2BJetTags");
+        myjet.CMVAv2 = alljets.getBTagDiscriminant(ijet, "pfCombinedMVAV2BJetTags");
+        myjet.JP = m_fillJetProbability ? alljets.getBTagDiscriminant(ijet, "pfJetProbabilityBJetTags") : 0;
+        float mybtag = alljets.getBTagDiscriminant(ijet, m_jet_bDiscrName);
+        //myjet.btag_L = mybtag > m_jet_bDiscrCut_loose;
+        myjet.btag_M = mybtag > m_jet_bDiscrCut_medium;
+        //myjet.btag_T = mybtag > m_jet_bDiscrCut_tight;
+        myjet.gen_matched_bParton = (std::abs(alljets.partonFlavor[ijet]) == 5);
+        myjet.gen_matched_bHadron = (alljets.hadronFlavor[ijet]) == 5;
+        myjet.gen_matched = alljets.matched[ijet];
+        myjet.gen_p4 = myjet.gen_matched ? alljets.gen_p4[ijet] : null_p4;
+        myjet.gen_DR = myjet.gen_matched ? ROOT::Math::VectorUtil::DeltaR(myjet.p4, myjet.gen_p4) : -1.;
+        myjet.gen_DPtOverPt = myjet.gen_matched ? (myjet.p4.Pt() - myjet.gen_p4.Pt()) / myjet.p4.Pt() : -10.;
+        myjet.gen_b = (alljets.hadronFlavor[ijet]) == 5; // redundant with gen_matched_bHadron defined above
+        myjet.gen_c = (alljets.hadronFlavor[ijet]) == 4;
+        myjet.gen_l = (alljets.hadronFlavor[ijet]) < 4;
+
+        if (!m_jetCut(myjet))
+            continue;
 
-            if (isThereACloseSelectedLepton)
-                continue;
+        jets.push_back(myjet);
+    }
 
-            jets.push_back(myjet);
+    // Pairwise kinematics of the selected jets with the leptons
+    jets_soa.clear();
+    for (const auto& jet: jets)
+        jets_soa.push_back(jet.p4);
+    HH::computeDeltaPhiDeltaR(jets_soa, leptons_soa, jl_DPhi, jl_DR);
+
+    // Bound the pairing combinatorics: only the best m_maxJetsForPairing jets are paired
+    pairing_jets.resize(jets.size());
+    std::iota(pairing_jets.begin(), pairing_jets.end(), 0);
+    jetPairingTruncated = (m_maxJetsForPairing > 0) && (jets.size() > m_maxJetsForPairing);
+    if (jetPairingTruncated) {
+        auto key = [this](unsigned int ijet) { return m_rankJetsForPairingByPt ? jets[ijet].p4.Pt() : jets[ijet].CMVAv2; };
+        std::partial_sort(pairing_jets.begin(), pairing_jets.begin() + m_maxJetsForPairing, pairing_jets.end(), [&key](unsigned int a, unsigned int b) { return key(a) > key(b); });
+        pairing_jets.resize(m_maxJetsForPairing);
+        std::sort(pairing_jets.begin(), pairing_jets.end());
+
+        if (! doingSystematics()) {
+            count_jetPairingTruncated++;
+            count_jetPairingDroppedJets += jets.size() - m_maxJetsForPairing;
         }
     }
 
-    // Do NOT change the loop logic here: we expect [0] to be made out of the leading jets
-    for (unsigned int ijet1 = 0; ijet1 < jets.size(); ijet1++)
-    {
-        for (unsigned int ijet2 = ijet1 + 1; ijet2 < jets.size(); ijet2++)
+    // Pairwise kinematics of the jets entering the pairing
+    pairing_jets_soa.clear();
+    pairing_position.assign(jets.size(), -1);
+    for (unsigned int i = 0; i < pairing_jets.size(); i++) {
+        pairing_jets_soa.push_back(jets[pairing_jets[i]].p4);
+        pairing_position[pairing_jets[i]] = i;
+    }
+    HH::computeDeltaPhiDeltaR(pairing_jets_soa, pairing_jets_soa, jj_DPhi, jj_DR);
+
+    if (!fillBestJetPairs() && !doingSystematics())
+        count_bestJetPairsOverflow++;
+
+    if (m_enumerateAllDijets) {
+        // Do NOT change the loop logic here: we expect [0] to be made out of the leading jets
+        for (unsigned int i1 = 0; i1 < pairing_jets.size(); i1++)
         {
-            HH::Dijet myjj;
-            myjj.p4 = jets[ijet1].p4 + jets[ijet2].p4;
-            myjj.idxs = std::make_pair(jets[ijet1].idx, jets[ijet2].idx);
-            myjj.ijet1 = ijet1;
-            myjj.ijet2 = ijet2;
-            //myjj.jid_LL = jets[ijet1].id_L && jets[ijet2].id_L;
-            //myjj.jid_TT = jets[ijet1].id_T && jets[ijet2].id_T;
-            //myjj.jid_TLVTLV = jets[ijet1].id_TLV && jets[ijet2].id_TLV;
-            //myjj.btag_LL = jets[ijet1].btag_L && jets[ijet2].btag_L;
-            //myjj.btag_LM = (jets[ijet1].btag_L && jets[ijet2].btag_M) || (jets[ijet2].btag_L && jets[ijet1].btag_M);
-            //myjj.btag_LT = (jets[ijet1].btag_L && jets[ijet2].btag_T) || (jets[ijet2].btag_L && jets[ijet1].btag_T);
-            //myjj.btag_ML = (jets[ijet1].btag_M && jets[ijet2].btag_L) || (jets[ijet2].btag_M && jets[ijet1].btag_L);
-            myjj.btag_MM = jets[ijet1].btag_M && jets[ijet2].btag_M;
-            //myjj.btag_MT = (jets[ijet1].btag_M && jets[ijet2].btag_T) || (jets[ijet2].btag_M && jets[ijet1].btag_T);
-            //myjj.btag_TL = (jets[ijet1].btag_T && jets[ijet2].btag_L) || (jets[ijet2].btag_T && jets[ijet1].btag_L);
-            //myjj.btag_TM = (jets[ijet1].btag_T && jets[ijet2].btag_M) || (jets[ijet2].btag_T && jets[ijet1].btag_M);
-            //myjj.btag_TT = jets[ijet1].btag_T && jets[ijet2].btag_T;
-            myjj.sumCSV = jets[ijet1].CSV + jets[ijet2].CSV;
-            myjj.sumCMVAv2 = jets[ijet1].CMVAv2 + jets[ijet2].CMVAv2;
-            myjj.DR_j_j = ROOT::Math::VectorUtil::DeltaR(jets[ijet1].p4, jets[ijet2].p4);
-            myjj.DPhi_j_j = fabs(ROOT::Math::VectorUtil::DeltaPhi(jets[ijet1].p4, jets[ijet2].p4));
-            myjj.ht_j_j = jets[ijet1].p4.Pt() + jets[ijet2].p4.Pt();
-            myjj.gen_matched_bbPartons = jets[ijet1].gen_matched_bParton && jets[ijet2].gen_matched_bParton; 
-            myjj.gen_matched_bbHadrons = jets[ijet1].gen_matched_bHadron && jets[ijet2].gen_matched_bHadron; 
-            myjj.gen_matched = jets[ijet1].gen_matched && jets[ijet2].gen_matched;
-            myjj.gen_p4 = myjj.gen_matched ? jets[ijet1].gen_p4 + jets[ijet2].gen_p4 : null_p4;
-            myjj.gen_DR = myjj.gen_matched ? ROOT::Math::VectorUtil::DeltaR(myjj.p4, myjj.gen_p4) : -1.;
-            myjj.gen_DPtOverPt = myjj.gen_matched ? (myjj.p4.Pt() - myjj.gen_p4.Pt()) / myjj.p4.Pt() : -10.;
-            myjj.gen_bb = (jets[ijet1].gen_b && jets[ijet2].gen_b);
-            myjj.gen_bc = (jets[ijet1].gen_b && jets[ijet2].gen_c) || (jets[ijet1].gen_c && jets[ijet2].gen_b);
-            myjj.gen_bl = (jets[ijet1].gen_b && jets[ijet2].gen_l) || (jets[ijet1].gen_l && jets[ijet2].gen_b);
-            myjj.gen_cc = (jets[ijet1].gen_c && jets[ijet2].gen_c);
-            myjj.gen_cl = (jets[ijet1].gen_c && jets[ijet2].gen_l) || (jets[ijet1].gen_l && jets[ijet2].gen_c);
-            myjj.gen_ll = (jets[ijet1].gen_l && jets[ijet2].gen_l);
-            jj.push_back(myjj);
+            for (unsigned int i2 = i1 + 1; i2 < pairing_jets.size(); i2++)
+            {
+                jj.push_back(makeDijet(pairing_jets[i1], pairing_jets[i2]));
+            }
         }
-    }
 
-    // have the jj collection sorted by ht
-    std::sort(jj.begin(), jj.end(), [&](HH::Dijet& a, HH::Dijet& b){return a.p4.Pt() > b.p4.Pt();});
+        // have the jj collection sorted by ht
+        std::sort(jj.begin(), jj.end(), [&](HH::Dijet& a, HH::Dijet& b){return a.p4.Pt() > b.p4.Pt();});
+    } else if (m_llmetjjCut.empty()) {
+        // The llmetjj candidate is ranked by sumCMVAv2: only the dijet made of the two jets with the highest CMVAv2 can be kept
+        std::pair<int, int> best_jets = findBestJetPair([](const HH::Jet& jet) { return jet.CMVAv2; });
+        if (best_jets.second >= 0)
+            jj.push_back(makeDijet(best_jets.first, best_jets.second));
+    }
+    // Otherwise, the best candidate can be rejected by llmetjjCut: the dijets are built on demand below, in rank order
+    bool buildDijetsOnDemand = !m_enumerateAllDijets && !m_llmetjjCut.empty();
 
     // ********** 
     // lljj, llbb, +pf_met
     // ********** 
+    // First pass: only the ranking key is computed for each combination, the full candidate is built afterwards
+    // for the kept combination only
     for (unsigned int illmet = 0; illmet < llmet.size(); illmet++)
     {
-        for (unsigned int ijj = 0; ijj < jj.size(); ijj++)
-        {
-            unsigned int imet = llmet[illmet].imet;
-            unsigned int ill = llmet[illmet].ill;
-            unsigned int ijet1 = jj[ijj].ijet1;
-            unsigned int ijet2 = jj[ijj].ijet2;
-            unsigned int ilep1 = ll[ill].ilep1;
-            unsigned int ilep2 = ll[ill].ilep2;
-            HH::DileptonMetDijet myllmetjj;
-            myllmetjj.p4 = ll[ill].p4 + jj[ijj].p4 + met[imet].p4;
-            myllmetjj.lep1_p4 = leptons[ilep1].p4;
-            myllmetjj.lep2_p4 = leptons[ilep2].p4;
-            myllmetjj.jet1_p4 = jets[ijet1].p4;
-            myllmetjj.jet2_p4 = jets[ijet2].p4;
-            myllmetjj.met_p4 = met[imet].p4;
-            myllmetjj.ll_p4 = ll[ill].p4;
-            myllmetjj.jj_p4 = jj[ijj].p4;
-            myllmetjj.lljj_p4 = ll[ill].p4 + jj[ijj].p4;
-            // gen info
-            myllmetjj.gen_matched = ll[ill].gen_matched && jj[ijj].gen_matched && met[imet].gen_matched;
-            myllmetjj.gen_p4 = myllmetjj.gen_matched ? ll[ill].gen_p4 + jj[ijj].gen_p4 + met[imet].gen_p4 : null_p4;
-            myllmetjj.gen_DR = myllmetjj.gen_matched ? ROOT::Math::VectorUtil::DeltaR(myllmetjj.p4, myllmetjj.gen_p4) : -1.;
-            myllmetjj.gen_DPhi = myllmetjj.gen_matched ? fabs(ROOT::Math::VectorUtil::DeltaPhi(myllmetjj.p4, myllmetjj.gen_p4)) : -1.;
-            myllmetjj.gen_DPtOverPt = myllmetjj.gen_matched ? (myllmetjj.p4.Pt() - myllmetjj.gen_p4.Pt()) / myllmetjj.p4.Pt() : -10.;
-            myllmetjj.gen_lep1_p4 = leptons[ilep1].gen_p4;
-            myllmetjj.gen_lep2_p4 = leptons[ilep2].gen_p4;
-            myllmetjj.gen_jet1_p4 = jets[ijet1].gen_p4;
-            myllmetjj.gen_jet2_p4 = jets[ijet2].gen_p4;
-            myllmetjj.gen_met_p4 = met[imet].gen_p4;
-            myllmetjj.gen_ll_p4 = ll[ill].gen_p4;
-            myllmetjj.gen_jj_p4 = jj[ijj].gen_p4;
-            myllmetjj.gen_lljj_p4 = ll[ill].gen_p4 + jj[ijj].gen_p4;
-            // blind copy of the jj content
-            myllmetjj.ijet1 = jj[ijj].ijet1;
-            myllmetjj.ijet2 = jj[ijj].ijet2;
-            //myllmetjj.jid_LL = jj[ijj].jid_LL;
-            //myllmetjj.jid_TT = jj[ijj].jid_TT;
-            //myllmetjj.jid_TLVTLV = jj[ijj].jid_TLVTLV;
-            //myllmetjj.btag_LL = jj[ijj].btag_LL;
-            //myllmetjj.btag_LM = jj[ijj].btag_LM;
-            //myllmetjj.btag_LT = jj[ijj].btag_LT;
-            //myllmetjj.btag_ML = jj[ijj].btag_ML;
-            myllmetjj.btag_MM = jj[ijj].btag_MM;
-            //myllmetjj.btag_MT = jj[ijj].btag_MT;
-            //myllmetjj.btag_TL = jj[ijj].btag_TL;
-            //myllmetjj.btag_TM = jj[ijj].btag_TM;
-            //myllmetjj.btag_TT = jj[ijj].btag_TT;
-            myllmetjj.sumCSV = jj[ijj].sumCSV;
-            myllmetjj.sumCMVAv2 = jj[ijj].sumCMVAv2;
-            myllmetjj.DR_j_j = jj[ijj].DR_j_j;
-            myllmetjj.DPhi_j_j = jj[ijj].DPhi_j_j;
-            myllmetjj.ht_j_j = jj[ijj].ht_j_j;
-            myllmetjj.gen_matched_bbPartons = jj[ijj].gen_matched_bbPartons;
-            myllmetjj.gen_matched_bbHadrons = jj[ijj].gen_matched_bbHadrons;
-            myllmetjj.gen_bb = jj[ijj].gen_bb;
-            myllmetjj.gen_bc = jj[ijj].gen_bc;
-            myllmetjj.gen_bl = jj[ijj].gen_bl;
-            myllmetjj.gen_cc = jj[ijj].gen_cc;
-            myllmetjj.gen_cl = jj[ijj].gen_cl;
-            myllmetjj.gen_ll = jj[ijj].gen_ll;
-            // blind copy of the llmet content
-            myllmetjj.ilep1 = ll[ill].ilep1;
-            myllmetjj.ilep2 = ll[ill].ilep2;
-            myllmetjj.isOS = ll[ill].isOS;
-            myllmetjj.isPlusMinus = ll[ill].isPlusMinus;
-            myllmetjj.isMinusPlus = ll[ill].isMinusPlus;
-            myllmetjj.isMuMu = ll[ill].isMuMu;
-            myllmetjj.isElEl = ll[ill].isElEl;
-            myllmetjj.isElMu = ll[ill].isElMu;
-            myllmetjj.isMuEl = ll[ill].isMuEl;
-            myllmetjj.isSF = ll[ill].isSF;
-            //myllmetjj.id_LL = ll[ill].id_LL;
-            //myllmetjj.id_LM = ll[ill].id_LM;
-            //myllmetjj.id_LT = ll[ill].id_LT;
-            //myllmetjj.id_LHWW = ll[ill].id_LHWW;
-            //myllmetjj.id_ML = ll[ill].id_ML;
-            //myllmetjj.id_MM = ll[ill].id_MM;
-            //myllmetjj.id_MT = ll[ill].id_MT;
-            //myllmetjj.id_MHWW = ll[ill].id_MHWW;
-            //myllmetjj.id_TL = ll[ill].id_TL;
-            //myllmetjj.id_TM = ll[ill].id_TM;
-            //myllmetjj.id_TT = ll[ill].id_TT;
-            //myllmetjj.id_THWW = ll[ill].id_THWW;
-            //myllmetjj.id_HWWL = ll[ill].id_HWWL;
-            //myllmetjj.id_HWWM = ll[ill].id_HWWM;
-            //myllmetjj.id_HWWT = ll[ill].id_HWWT;
-            //myllmetjj.id_HWWHWW = ll[ill].id_HWWHWW;
-            //myllmetjj.iso_LL = ll[ill].iso_LL;
-            //myllmetjj.iso_LT = ll[ill].iso_LT;
-            //myllmetjj.iso_LHWW = ll[ill].iso_LHWW;
-            //myllmetjj.iso_TL = ll[ill].iso_TL;
-            //myllmetjj.iso_TT = ll[ill].iso_TT;
-            //myllmetjj.iso_THWW = ll[ill].iso_THWW;
-            //myllmetjj.iso_HWWL = ll[ill].iso_HWWL;
-            //myllmetjj.iso_HWWT = ll[ill].iso_HWWT;
-            //myllmetjj.iso_HWWHWW = ll[ill].iso_HWWHWW;
-            myllmetjj.DR_l_l = ll[ill].DR_l_l;
-            myllmetjj.DPhi_l_l = ll[ill].DPhi_l_l;
-            myllmetjj.ht_l_l = ll[ill].ht_l_l;
-            myllmetjj.trigger_efficiency = ll[ill].trigger_efficiency;
-            myllmetjj.trigger_efficiency_downVariated = ll[ill].trigger_efficiency_downVariated;
-            myllmetjj.trigger_efficiency_upVariated = ll[ill].trigger_efficiency_upVariated;
-            //myllmetjj.ill = ill;
-            myllmetjj.imet = imet;
-            myllmetjj.isNoHF = met[imet].isNoHF;
-            myllmetjj.DPhi_ll_met = llmet[illmet].DPhi_ll_met;
-            myllmetjj.minDPhi_l_met = llmet[illmet].minDPhi_l_met; 
-            myllmetjj.maxDPhi_l_met = llmet[illmet].maxDPhi_l_met;
-            myllmetjj.MT = llmet[illmet].MT;
-            myllmetjj.MT_formula = llmet[illmet].MT_formula;
-            myllmetjj.projectedMet = llmet[illmet].projectedMet;
-            // content specific to HH::DijetMet
-            // NB: computed for the first time here, no intermediate jjmet collection
-            myllmetjj.DPhi_jj_met = fabs(ROOT::Math::VectorUtil::DeltaPhi(jj[ijj].p4, met[imet].p4));
-            myllmetjj.minDPhi_j_met = std::min(fabs(ROOT::Math::VectorUtil::DeltaPhi(jets[jj[ijj].ijet1].p4, met[imet].p4)), fabs(ROOT::Math::VectorUtil::DeltaPhi(jets[jj[ijj].ijet2].p4, met[imet].p4)));
-            myllmetjj.maxDPhi_j_met = std::max(fabs(ROOT::Math::VectorUtil::DeltaPhi(jets[jj[ijj].ijet1].p4, met[imet].p4)), fabs(ROOT::Math::VectorUtil::DeltaPhi(jets[jj[ijj].ijet2].p4, met[imet].p4)));
-            // content specific to HH::DileptonMetDijet
-            //myllmetjj.illmet = illmet;
-            //myllmetjj.ijj = ijj;
-            float DR_j1l1, DR_j1l2, DR_j2l1, DR_j2l2;
-            DR_j1l1 = ROOT::Math::VectorUtil::DeltaR(jets[ijet1].p4, leptons[ilep1].p4);
-            DR_j1l2 = ROOT::Math::VectorUtil::DeltaR(jets[ijet1].p4, leptons[ilep2].p4);
-            DR_j2l1 = ROOT::Math::VectorUtil::DeltaR(jets[ijet2].p4, leptons[ilep1].p4);
-            DR_j2l2 = ROOT::Math::VectorUtil::DeltaR(jets[ijet2].p4, leptons[ilep2].p4);
-            myllmetjj.maxDR_l_j = std::max({DR_j1l1, DR_j1l2, DR_j2l1, DR_j2l2});
-            myllmetjj.minDR_l_j = std::min({DR_j1l1, DR_j1l2, DR_j2l1, DR_j2l2});
-            myllmetjj.DR_ll_jj = ROOT::Math::VectorUtil::DeltaR(ll[ill].p4, jj[ijj].p4);
-            myllmetjj.DPhi_ll_jj = fabs(ROOT::Math::VectorUtil::DeltaPhi(ll[ill].p4, jj[ijj].p4));
-            myllmetjj.DR_llmet_jj = ROOT::Math::VectorUtil::DeltaR(llmet[illmet].p4, jj[ijj].p4);
-            myllmetjj.DPhi_llmet_jj = fabs(ROOT::Math::VectorUtil::DeltaPhi(llmet[illmet].p4, jj[ijj].p4));
-            myllmetjj.cosThetaStar_CS = fabs(getCosThetaStar_CS(llmet[illmet].p4, jj[ijj].p4));
-            myllmetjj.MT_fullsystem = myllmetjj.p4.Mt();
-            myllmetjj.melaAngles = getMELAAngles(llmet[illmet].p4, jj[ijj].p4, leptons[ilep1].p4, leptons[ilep2].p4, jets[ijet1].p4, jets[ijet2].p4);
-            myllmetjj.visMelaAngles = getMELAAngles(ll[ill].p4, jj[ijj].p4, leptons[ilep1].p4, leptons[ilep2].p4, jets[ijet1].p4, jets[ijet2].p4); // only take the visible part of the H(ww) candidate
-
-            // Compute MT2. See https://arxiv.org/pdf/1309.6318v1.pdf and https://arxiv.org/pdf/1411.4312v5.pdf
-            double px_invisible = myllmetjj.lep1_p4.px() + myllmetjj.lep2_p4.px() + myllmetjj.met_p4.px();
-            double py_invisible = myllmetjj.lep1_p4.py() + myllmetjj.lep2_p4.py() + myllmetjj.met_p4.py();
-
-            myllmetjj.MT2 = asymm_mt2_lester_bisect::get_mT2(
-                    myllmetjj.jet1_p4.M(), myllmetjj.jet1_p4.px(), myllmetjj.jet1_p4.py(),
-                    myllmetjj.jet2_p4.M(), myllmetjj.jet2_p4.px(), myllmetjj.jet2_p4.py(),
-                    px_invisible, py_invisible,
-                    myllmetjj.lep1_p4.M(), myllmetjj.lep2_p4.M(),
-                    0.5 // Absolute precision
-                    );
-
-
-            // Counters
-            tmp_count_has2leptons_1llmetjj = event_weight;
-            if (myllmetjj.isElEl)
-                tmp_count_has2leptons_elel_1llmetjj = event_weight;
-            if (myllmetjj.isElMu)
-                tmp_count_has2leptons_elmu_1llmetjj = event_weight;
-            if (myllmetjj.isMuEl)
-                tmp_count_has2leptons_muel_1llmetjj = event_weight;
-            if (myllmetjj.isMuMu)
-                tmp_count_has2leptons_mumu_1llmetjj = event_weight;
-            if (myllmetjj.btag_MM)
+        if (buildDijetsOnDemand) {
+            for (unsigned int i1 = 0; i1 < pairing_jets.size(); i1++)
             {
-                tmp_count_has2leptons_1llmetjj_2btagM = event_weight;
-                if (myllmetjj.isElEl)
-                    tmp_count_has2leptons_elel_1llmetjj_2btagM = event_weight;
-                if (myllmetjj.isElMu)
-                    tmp_count_has2leptons_elmu_1llmetjj_2btagM = event_weight;
-                if (myllmetjj.isMuEl)
-                    tmp_count_has2leptons_muel_1llmetjj_2btagM = event_weight;
-                if (myllmetjj.isMuMu)
-                    tmp_count_has2leptons_mumu_1llmetjj_2btagM = event_weight;
+                for (unsigned int i2 = i1 + 1; i2 < pairing_jets.size(); i2++)
+                {
+                    HH::DileptonMetDijetCandidate candidate;
+                    candidate.illmet = illmet;
+                    candidate.ijet1 = pairing_jets[i1];
+                    candidate.ijet2 = pairing_jets[i2];
+                    candidate.sumCMVAv2 = jets[candidate.ijet1].CMVAv2 + jets[candidate.ijet2].CMVAv2;
+                    llmetjj_candidates.push_back(candidate);
+                }
             }
-            // Fill
-            llmetjj.push_back(myllmetjj);
+            continue;
         }
+        for (unsigned int ijj = 0; ijj < jj.size(); ijj++)
+        {
+            HH::DileptonMetDijetCandidate candidate;
+            candidate.illmet = illmet;
+            candidate.ijj = ijj;
+            candidate.ijet1 = jj[ijj].ijet1;
+            candidate.ijet2 = jj[ijj].ijet2;
+            candidate.sumCMVAv2 = jj[ijj].sumCMVAv2;
+            llmetjj_candidates.push_back(candidate);
+        }
+    }
+
+    std::sort(llmetjj_candidates.begin(), llmetjj_candidates.end(), [&](HH::DileptonMetDijetCandidate& a, const HH::DileptonMetDijetCandidate& b){ return a.sumCMVAv2 > b.sumCMVAv2; });
+
+    // Second pass: the full candidates are built in rank order, until one passes llmetjjCut (the first one without a cut),
+    // which is the only one kept. The candidates which can be tried are all the ranked ones with a cut, the first one
+    // otherwise
+    size_t n_tried = m_llmetjjCut.empty() ? std::min<size_t>(llmetjj_candidates.size(), 1) : llmetjj_candidates.size();
+
+    // Angular variables: the MELA angles of the full and visible (ll instead of llmet) H(ww) candidates, and cos theta star,
+    // in one batch for the candidates which can be tried
+    mela_inputs.clear();
+    for (size_t i = 0; i < n_tried; i++)
+        mela_inputs.push_back(makeMELAInputs(llmetjj_candidates[i].illmet, llmetjj_candidates[i].ijet1, llmetjj_candidates[i].ijet2));
+    HH::computeMELAAngles(mela_inputs, mela_results, [this](double x) -> double {
+            return evaluateKinematics("acos", [x]() -> float { return std::acos(x); }, [x]() { return HH::fastmath::acos(x); });
+        });
+
+    // MT2, in one batch as well. See https://arxiv.org/pdf/1309.6318v1.pdf and https://arxiv.org/pdf/1411.4312v5.pdf
+    mt2_inputs.clear();
+    for (size_t i = 0; i < n_tried; i++)
+        mt2_inputs.push_back(makeMT2Input(llmetjj_candidates[i].illmet, llmetjj_candidates[i].ijet1, llmetjj_candidates[i].ijet2));
+    m_mt2Engine.compute(mt2_inputs, mt2_results);
+    if (! doingSystematics()) {
+        count_mt2Evaluations += n_tried;
+        for (const auto& result: mt2_results)
+            count_mt2Iterations += result.iterations;
     }
 
-    std::sort(llmetjj.begin(), llmetjj.end(), [&](HH::DileptonMetDijet& a, const HH::DileptonMetDijet& b){ return a.sumCMVAv2 > b.sumCMVAv2; });
+    for (size_t i = 0; i < n_tried; i++) {
+        HH::DileptonMetDijetCandidate& candidate = llmetjj_candidates[i];
+        if (buildDijetsOnDemand) {
+            // The same dijet can be tried with several llmet
+            candidate.ijj = std::find_if(jj.begin(), jj.end(), [&candidate](const HH::Dijet& dijet) { return dijet.ijet1 == candidate.ijet1 && dijet.ijet2 == candidate.ijet2; }) - jj.begin();
+            if (candidate.ijj == jj.size())
+                jj.push_back(makeDijet(candidate.ijet1, candidate.ijet2));
+        }
+
+        llmetjj.push_back(makeDileptonMetDijet(candidate.illmet, candidate.ijj));
+        HH::DileptonMetDijet& myllmetjj = llmetjj.back();
+
+        myllmetjj.cosThetaStar_CS = std::abs(mela_results[i].cosThetaStar_CS);
+        myllmetjj.melaAngles = mela_results[i].full;
+        myllmetjj.visMelaAngles = mela_results[i].visible;
+
+        myllmetjj.MT2 = mt2_results[i].MT2;
+
+        // Additional cut, once all the variables of the candidate are known
+        if (m_llmetjjCut(myllmetjj))
+            break;
+        llmetjj.pop_back();
+    }
 
-    // Keep only the first candidate
-    if (llmetjj.size() > 1) {
-        llmetjj.resize(1);
+    // Counters, for the kept candidate. All the combinations share the same dilepton, and the b-tagging flag only
+    // depends on the jets entering the pairing
+    if (!llmetjj.empty()) {
+        const HH::DileptonMetDijet& kept = llmetjj.front();
+        bool hasBtagMMDijet = std::count_if(pairing_jets.begin(), pairing_jets.end(), [this](unsigned int ijet) { return jets[ijet].btag_M; }) >= 2;
+        tmp_count_has2leptons_1llmetjj = event_weight;
+        if (kept.isElEl)
+            tmp_count_has2leptons_elel_1llmetjj = event_weight;
+        if (kept.isElMu)
+            tmp_count_has2leptons_elmu_1llmetjj = event_weight;
+        if (kept.isMuEl)
+            tmp_count_has2leptons_muel_1llmetjj = event_weight;
+        if (kept.isMuMu)
+            tmp_count_has2leptons_mumu_1llmetjj = event_weight;
+        if (hasBtagMMDijet)
+        {
+            tmp_count_has2leptons_1llmetjj_2btagM = event_weight;
+            if (kept.isElEl)
+                tmp_count_has2leptons_elel_1llmetjj_2btagM = event_weight;
+            if (kept.isElMu)
+                tmp_count_has2leptons_elmu_1llmetjj_2btagM = event_weight;
+            if (kept.isMuEl)
+                tmp_count_has2leptons_muel_1llmetjj_2btagM = event_weight;
+            if (kept.isMuMu)
+                tmp_count_has2leptons_mumu_1llmetjj_2btagM = event_weight;
+        }
     }
 
     // ***** ***** *****
@@ -948,8 +609,296 @@ void HHAnalyzer::analyze(const edm::Event& event, const edm::EventSetup&, const
     }
 
 
-    if (!event.isRealData() && !doingSystematics())
-    {
+    if (!event.isRealData() && !doingSystematics() && (!m_genTruthAfterRecoSelection || !ll.empty()))
+        fillTTGenInfo(producers.get<GenParticlesProducer>("gen_particles"));
+
+}
+
+bool HHAnalyzer::passTauBRReweighting(const EventProducer& fwevent, const GenParticlesProducer& gp) {
+    // Lightweight pass over the hard process, only finding the two Higgs and counting the taus coming
+    // directly from a W or a Z in their decays, with the same logic as in fillHHGenInfo
+    constexpr double BR_tau_e_mu = 0.3524;
+    size_t n_taus = 0;
+    bool is_signal = false;
+    int iH1 = -1, iH2 = -1;
+
+    std::function<bool(size_t, size_t)> pruned_decays_from = [&pruned_decays_from, &gp](size_t particle_index, size_t mother_index) -> bool {
+        if (gp.pruned_mothers_index[particle_index].empty())
+            return false;
+
+        size_t index = gp.pruned_mothers_index[particle_index][0];
+        return (index == mother_index) || pruned_decays_from(index, mother_index);
+    };
+
+    std::function<bool(size_t, size_t, bool)> pruned_decays_from_pdg_id = [&pruned_decays_from_pdg_id, &gp](size_t particle_index, uint64_t pdg_id, bool direct) -> bool {
+        if (gp.pruned_mothers_index[particle_index].empty())
+            return false;
+
+        size_t index = gp.pruned_mothers_index[particle_index][0];
+        return (std::abs(gp.pruned_pdg_id[index]) == pdg_id) || (!direct && pruned_decays_from_pdg_id(index, pdg_id, direct));
+    };
+
+    for (unsigned int ip = 0; ip < gp.pruned_p4.size(); ip++) {
+        std::bitset<15> flags (gp.pruned_status_flags[ip]);
+
+        if (!flags.test(8))
+            continue;
+
+        int64_t pdg_id = gp.pruned_pdg_id[ip];
+
+        if ((pdg_id == 25) && flags.test(7)) {
+            if (iH1 == -1)
+                iH1 = ip;
+            else if (iH2 == -1)
+                iH2 = ip;
+        }
+
+        if ((iH1 == -1) || (iH2 == -1))
+            continue;
+
+        is_signal = true;
+
+        if (std::abs(pdg_id) != 15)
+            continue;
+
+        if (!pruned_decays_from(ip, iH1) && !pruned_decays_from(ip, iH2))
+            continue;
+
+        // Ignore B decays
+        if (pruned_decays_from_pdg_id(ip, 5, false))
+            continue;
+
+        if (pruned_decays_from_pdg_id(ip, 24, true) || pruned_decays_from_pdg_id(ip, 23, true))
+            n_taus++;
+    }
+
+    if (!is_signal)
+        return true;
+
+    // FIXME Moriond 2017
+    if (n_taus > 2) {
+        std::cout << "ERROR: More than two taus coming from Higgs decays. There's something wrong!" << std::endl;
+    }
+
+    double factor = std::pow(BR_tau_e_mu, n_taus);
+
+    // Seeded from the event id, so that the throw does not depend on the events processed before, which change with
+    // the category gates and the processing order
+    std::seed_seq seed{42u, fwevent.run, fwevent.lumi, static_cast<unsigned int>(fwevent.event), static_cast<unsigned int>(fwevent.event >> 32)};
+    random_generator.seed(seed);
+    return br_generator(random_generator) <= factor;
+}
+
+void HHAnalyzer::fillHHGenInfo(const GenParticlesProducer& gp, const JetsProducer& alljets, const ElectronsProducer& allelectrons, const MuonsProducer& allmuons) {
+// ***** ***** *****
+// Get the MC truth information on the hard process
+// ***** ***** *****
+// from https://github.com/cms-sw/cmssw/blob/CMSSW_7_4_X/DataFormats/HepMCCandidate/interface/GenStatusFlags.h
+//    enum StatusBits {
+//0      kIsPrompt = 0,
+//1      kIsDecayedLeptonHadron,
+//2      kIsTauDecayProduct,
+//3      kIsPromptTauDecayProduct,
+//4      kIsDirectTauDecayProduct,
+//5      kIsDirectPromptTauDecayProduct,
+//6      kIsDirectHadronDecayProduct,
+//7      kIsHardProcess,
+//8      kFromHardProcess,
+//9      kIsHardProcessTauDecayProduct,
+//10      kIsDirectHardProcessTauDecayProduct,
+//11      kFromHardProcessBeforeFSR,
+//12      kIsFirstCopy,
+//13      kIsLastCopy,
+//14      kIsLastCopyBeforeFSR
+//    };
+
+
+#if HH_GEN_DEBUG
+    std::function<void(size_t)> print_mother_chain = [&gp, &print_mother_chain](size_t p) {
+
+        if (gp.pruned_mothers_index[p].empty()) {
+            std::cout << std::endl;
+            return;
+        }
+
+        size_t index = gp.pruned_mothers_index[p][0];
+        std::cout << " <- #" << index << "(" << gp.pruned_pdg_id[index] << ")";
+        print_mother_chain(index);
+    };
+#endif
+
+    std::function<bool(size_t, size_t)> pruned_decays_from = [&pruned_decays_from, &gp](size_t particle_index, size_t mother_index) -> bool {
+        // Iterator over all pruned particles to find if the particle `particle_index` has `mother_index` in its decay history
+        if (gp.pruned_mothers_index[particle_index].empty())
+            return false;
+
+        size_t index = gp.pruned_mothers_index[particle_index][0];
+
+        if (index == mother_index) {
+            return true;
+        }
+
+        if (pruned_decays_from(index, mother_index))
+            return true;
+
+        return false;
+    };
+
+    std::function<bool(size_t, size_t, bool)> pruned_decays_from_pdg_id = [&pruned_decays_from_pdg_id, &gp](size_t particle_index, uint64_t pdg_id, bool direct) -> bool {
+        // Iterator over all pruned particles to find if the particle `particle_index` decays from a particle with pdg id == pdg_id
+        if (gp.pruned_mothers_index[particle_index].empty())
+            return false;
+
+        size_t index = gp.pruned_mothers_index[particle_index][0];
+
+        if (std::abs(gp.pruned_pdg_id[index]) == pdg_id) {
+            return true;
+        }
+
+        if (!direct && pruned_decays_from_pdg_id(index, pdg_id, direct))
+            return true;
+
+        return false;
+    };
+
+    // Construct signal gen info
+
+    gen_iX = -1;
+    gen_iH1 = gen_iH2 = -1;
+    gen_iH1_afterFSR = gen_iH2_afterFSR = -1;
+    gen_iB = gen_iBbar = -1;
+    gen_iB_afterFSR = gen_iBbar_afterFSR = -1;
+    gen_iV2 = gen_iV1 = -1;
+    gen_iV2_afterFSR = gen_iV1_afterFSR = -1;
+    gen_iLminus = gen_iLplus = -1;
+    gen_iLminus_afterFSR = gen_iLplus_afterFSR = -1;
+    gen_iNu1 = gen_iNu2 = -1;
+
+    for (unsigned int ip = 0; ip < gp.pruned_p4.size(); ip++) {
+        std::bitset<15> flags (gp.pruned_status_flags[ip]);
+
+        if (!flags.test(8))
+            continue;
+
+        int64_t pdg_id = gp.pruned_pdg_id[ip];
+
+#if HH_GEN_DEBUG
+        std::cout << "[" << ip << "] pdg id: " << pdg_id << "  flags: " << flags << "  p = " << gp.pruned_p4[ip] << std::endl;
+        print_mother_chain(ip);
+#endif
+
+        auto p4 = gp.pruned_p4[ip];
+
+        if (std::abs(pdg_id) == 35 || std::abs(pdg_id) == 39) {
+            ASSIGN_HH_GEN_INFO_NO_FSR(X, "X");
+        } else if (pdg_id == 25) {
+            ASSIGN_HH_GEN_INFO_2(H1, H2, "Higgs");
+        }
+
+        // Only look for Higgs decays if we have found the two Higgs
+        if ((gen_iH1 == -1) || (gen_iH2 == -1))
+            continue;
+
+        // And if the particle actually come directly from a Higgs
+        bool from_h1_decay = pruned_decays_from(ip, gen_iH1);
+        bool from_h2_decay = pruned_decays_from(ip, gen_iH2);
+
+        // Only keep particles coming from the Higgs decay
+        if (! from_h1_decay && ! from_h2_decay)
+            continue;
+
+        if (pdg_id == 5) {
+            ASSIGN_HH_GEN_INFO(B, "B");
+        } else if (pdg_id == -5) {
+            ASSIGN_HH_GEN_INFO(Bbar, "Bbar");
+        }
+
+        // Ignore B decays
+        if (pruned_decays_from_pdg_id(ip, 5, false))
+            continue;
+
+        if ((pdg_id == 11) || (pdg_id == 13) || (pdg_id == 15)) {
+            ASSIGN_HH_GEN_INFO(Lminus, "L-");
+        } else if ((pdg_id == -11) || (pdg_id == -13) || (pdg_id == -15)) {
+            ASSIGN_HH_GEN_INFO(Lplus, "L+");
+        } else if ((pdg_id == 23) || (std::abs(pdg_id) == 24)) {
+            ASSIGN_HH_GEN_INFO_2(V1, V2, "W/Z bosons");
+        } else if ((std::abs(pdg_id) == 12) || (std::abs(pdg_id) == 14) || (std::abs(pdg_id) == 16)) {
+            ASSIGN_HH_GEN_INFO_2_NO_FSR(Nu1, Nu2, "neutrinos");
+        }
+    }
+
+    // Swap neutrinos if needed
+    if ((gen_iNu1 != -1) && (gen_iNu2 != -1)) {
+        if (gp.pruned_pdg_id[gen_iNu1] > 0) {
+            std::swap(gen_iNu1, gen_iNu2);
+            std::swap(gen_Nu1, gen_Nu2);
+        }
+    }
+
+    if ((gen_iH1 != -1) && (gen_iH2 != -1)) {
+        gen_mHH = (gen_H1 + gen_H2).M();
+        gen_costhetastar = getCosThetaStar_CS(gen_H1, gen_H2);
+    }
+
+#if HH_GEN_DEBUG
+    PRINT_PARTICULE(X);
+    PRINT_RESONANCE(H1, H2);
+    PRINT_RESONANCE(B, Bbar);
+    PRINT_RESONANCE(V1, V2);
+    PRINT_RESONANCE(Lminus, Lplus);
+    PRINT_RESONANCE_NO_FSR(Nu1, Nu2);
+
+    // Rebuild resonances for consistency checks
+    auto LminusNu1 = gen_Lminus + gen_Nu1;
+    std::cout << "    gen_(L- Nu1).M() = " << LminusNu1.M() << std::endl;
+
+    auto LplusNu2 = gen_Lplus + gen_Nu2;
+    std::cout << "    gen_(L+ Nu2).M() = " << LplusNu2.M() << std::endl;
+
+    auto LminusNu1_afterFSR = gen_Lminus_afterFSR + gen_Nu1;
+    std::cout << "    gen_(L- Nu1)_afterFSR.M() = " << LminusNu1_afterFSR.M() << std::endl;
+
+    auto LplusNu2_afterFSR = gen_Lplus_afterFSR + gen_Nu2;
+    std::cout << "    gen_(L+ Nu2)_afterFSR.M() = " << LplusNu2_afterFSR.M() << std::endl;
+    
+    auto LLNuNu = gen_Lplus + gen_Lminus + gen_Nu1 + gen_Nu2;
+    std::cout << "    gen_(LL NuNu).M() = " << LLNuNu.M() << std::endl;
+
+    auto LLNuNu_afterFSR = gen_Lplus_afterFSR + gen_Lminus_afterFSR + gen_Nu1 + gen_Nu2;
+    std::cout << "    gen_(LL NuNu)_afterFSR.M() = " << LLNuNu_afterFSR.M() << std::endl;
+
+    auto LLNuNuBB = gen_Lplus + gen_Lminus + gen_Nu1 + gen_Nu2 + gen_B + gen_Bbar;
+    std::cout << "    gen_(LL NuNu BB).M() = " << LLNuNuBB.M() << std::endl;
+
+    auto LLNuNuBB_afterFSR = gen_Lplus_afterFSR + gen_Lminus_afterFSR + gen_Nu1 + gen_Nu2 + gen_B_afterFSR + gen_Bbar_afterFSR;
+    std::cout << "    gen_(LL NuNu BB)_afterFSR.M() = " << LLNuNuBB_afterFSR.M() << std::endl;
+#endif
+
+    // ***** ***** *****
+    // Matching
+    // ***** ***** *****
+    for (auto p4: alljets.gen_p4) {
+        gen_deltaR_jet_B.push_back(deltaR(p4, gen_B));
+        gen_deltaR_jet_Bbar.push_back(deltaR(p4, gen_Bbar));
+        gen_deltaR_jet_B_afterFSR.push_back(deltaR(p4, gen_B_afterFSR));
+        gen_deltaR_jet_Bbar_afterFSR.push_back(deltaR(p4, gen_Bbar_afterFSR));
+    }
+    for (auto p4: allelectrons.gen_p4) {
+        gen_deltaR_electron_L1.push_back(deltaR(p4, gen_Lminus));
+        gen_deltaR_electron_L2.push_back(deltaR(p4, gen_Lplus));
+        gen_deltaR_electron_L1_afterFSR.push_back(deltaR(p4, gen_Lminus_afterFSR));
+        gen_deltaR_electron_L2_afterFSR.push_back(deltaR(p4, gen_Lplus_afterFSR));
+    }
+    for (auto p4: allmuons.gen_p4) {
+        gen_deltaR_muon_L1.push_back(deltaR(p4, gen_Lminus));
+        gen_deltaR_muon_L2.push_back(deltaR(p4, gen_Lplus));
+        gen_deltaR_muon_L1_afterFSR.push_back(deltaR(p4, gen_Lminus_afterFSR));
+        gen_deltaR_muon_L2_afterFSR.push_back(deltaR(p4, gen_Lplus_afterFSR));
+    }
+}
+
+void HHAnalyzer::fillTTGenInfo(const GenParticlesProducer& gen_particles) {
 // ***** ***** *****
 // Get the MC truth information on the hard process
 // ***** ***** *****
@@ -974,7 +923,6 @@ void HHAnalyzer::analyze(const edm::Event& event, const edm::EventSetup&, const
 
 
     // TTBAR MC TRUTH
-    const GenParticlesProducer& gen_particles = producers.get<GenParticlesProducer>("gen_particles");
 
     // 'Pruned' particles are from the hard process
     // 'Packed' particles are stable particles
@@ -1307,8 +1255,313 @@ void HHAnalyzer::analyze(const edm::Event& event, const edm::EventSetup&, const
         std::cout << "Error: unknown ttbar decay." << std::endl;
         gen_ttbar_decay_type = UnknownTT;
     }
-    } // end of if !event.isRealData()
+}
+
+bool HHAnalyzer::fillBestJetPairs() {
+    bestJetPairs.assign(jetPair::Count, std::make_pair(-1, -1));
+    if (pairing_jets.size() < 2)
+        return true;
+
+    // The indices are stored as int8_t: a pair with a jet beyond is stored as (-1, -1)
+    bool fit = true;
+    auto storedPair = [&fit](int ijet1, int ijet2) -> std::pair<int8_t, int8_t> {
+        if (std::max(ijet1, ijet2) > std::numeric_limits<int8_t>::max()) {
+            fit = false;
+            return std::make_pair(-1, -1);
+        }
+        return std::make_pair(static_cast<int8_t>(ijet1), static_cast<int8_t>(ijet2));
+    };
+
+    // Orderings on a sum of per-jet quantities only need a single pass on the jets,
+    // the others share the dijet kinematics computed once per jet pair
+    bool needDijetKinematics = false;
+    std::pair<int, int> best;
+    for (const jetPair::jetPair& strategy: m_jetPairStrategies) {
+        switch (strategy) {
+            case jetPair::ht:
+                best = findBestJetPair([](const HH::Jet& jet) { return jet.p4.Pt(); });
+                break;
+            case jetPair::csv:
+                best = findBestJetPair([](const HH::Jet& jet) { return jet.CSV; });
+                break;
+            case jetPair::jp:
+                best = findBestJetPair([](const HH::Jet& jet) { return jet.JP; });
+                break;
+            default:
+                needDijetKinematics = true;
+                continue;
+        }
+        bestJetPairs[strategy] = storedPair(best.first, best.second);
+    }
+
+    if (!needDijetKinematics)
+        return fit;
+
+    HH::computePairMassPt(pairing_jets_soa, jj_M, jj_Pt);
+
+    std::array<std::pair<int, int>, jetPair::Count> bestDijets;
+    bestDijets.fill(std::make_pair(-1, -1));
+    float min_DM_h = std::numeric_limits<float>::max();
+    float max_pt = -1.;
+    float max_ptOverM = -1.;
+    for (unsigned int i1 = 0; i1 < pairing_jets.size(); i1++)
+    {
+        for (unsigned int i2 = i1 + 1; i2 < pairing_jets.size(); i2++)
+        {
+            unsigned int ijet1 = pairing_jets[i1];
+            unsigned int ijet2 = pairing_jets[i2];
+            float pt = jj_Pt(i1, i2);
+            float mass = jj_M(i1, i2);
+            if (std::abs(mass - 125.) < min_DM_h) {
+                min_DM_h = std::abs(mass - 125.);
+                bestDijets[jetPair::mh] = std::make_pair(ijet1, ijet2);
+            }
+            if (pt > max_pt) {
+                max_pt = pt;
+                bestDijets[jetPair::pt] = std::make_pair(ijet1, ijet2);
+            }
+            if (mass > 0 && pt / mass > max_ptOverM) {
+                max_ptOverM = pt / mass;
+                bestDijets[jetPair::ptOverM] = std::make_pair(ijet1, ijet2);
+            }
+        }
+    }
+
+    for (const jetPair::jetPair& strategy: m_jetPairStrategies) {
+        if (strategy == jetPair::mh || strategy == jetPair::pt || strategy == jetPair::ptOverM)
+            bestJetPairs[strategy] = storedPair(bestDijets[strategy].first, bestDijets[strategy].second);
+    }
+    return fit;
+}
+
+HH::Dilepton HHAnalyzer::makeDilepton(unsigned int ilep1, unsigned int ilep2) {
+    LorentzVector null_p4(0., 0., 0., 0.);
+    HH::Dilepton dilep;
+    dilep.p4 = (leptons_soa.fourVector(ilep1) + leptons_soa.fourVector(ilep2)).p4();
+    dilep.idxs = std::make_pair(leptons[ilep1].idx, leptons[ilep2].idx);
+    dilep.ilep1 = ilep1;
+    dilep.ilep2 = ilep2;
+    dilep.isOS = leptons[ilep1].charge * leptons[ilep2].charge < 0;
+    dilep.isPlusMinus = leptons[ilep1].charge > 0 && leptons[ilep2].charge < 0;
+    dilep.isMinusPlus = leptons[ilep1].charge < 0 && leptons[ilep2].charge > 0;
+    dilep.isMuMu = leptons[ilep1].isMu && leptons[ilep2].isMu;
+    dilep.isElEl = leptons[ilep1].isEl && leptons[ilep2].isEl;
+    dilep.isElMu = leptons[ilep1].isEl && leptons[ilep2].isMu;
+    dilep.isMuEl = leptons[ilep1].isMu && leptons[ilep2].isEl;
+    dilep.isSF = dilep.isMuMu || dilep.isElEl;
+    //dilep.id_LL = leptons[ilep1].id_L && leptons[ilep2].id_L;
+    //dilep.id_LM = (leptons[ilep1].id_L && leptons[ilep2].id_M) || (leptons[ilep2].id_L && leptons[ilep1].id_M);
+    //dilep.id_LT = (leptons[ilep1].id_L && leptons[ilep2].id_T) || (leptons[ilep2].id_L && leptons[ilep1].id_T);
+    //dilep.id_LHWW = (leptons[ilep1].id_L && leptons[ilep2].id_HWW) || (leptons[ilep2].id_L && leptons[ilep1].id_HWW);
+    //dilep.id_ML = (leptons[ilep1].id_M && leptons[ilep2].id_L) || (leptons[ilep2].id_M && leptons[ilep1].id_L);
+    //dilep.id_MM = leptons[ilep1].id_M && leptons[ilep2].id_M;
+    //dilep.id_MT = (leptons[ilep1].id_T && leptons[ilep2].id_M) || (leptons[ilep2].id_T && leptons[ilep1].id_M);
+    //dilep.id_MHWW = (leptons[ilep1].id_M && leptons[ilep2].id_HWW) || (leptons[ilep2].id_M && leptons[ilep1].id_HWW);
+    //dilep.id_TL = (leptons[ilep1].id_T && leptons[ilep2].id_L) || (leptons[ilep2].id_T && leptons[ilep1].id_L);
+    //dilep.id_TM = (leptons[ilep1].id_T && leptons[ilep2].id_M) || (leptons[ilep2].id_T && leptons[ilep1].id_M);
+    //dilep.id_TT = leptons[ilep1].id_T && leptons[ilep2].id_T;
+    //dilep.id_THWW = (leptons[ilep1].id_T && leptons[ilep2].id_HWW) || (leptons[ilep2].id_T && leptons[ilep1].id_HWW);
+    //dilep.id_HWWL = (leptons[ilep1].id_HWW && leptons[ilep2].id_L) || (leptons[ilep2].id_HWW && leptons[ilep1].id_L);
+    //dilep.id_HWWM = (leptons[ilep1].id_HWW && leptons[ilep2].id_M) || (leptons[ilep2].id_HWW && leptons[ilep1].id_M);
+    //dilep.id_HWWT = (leptons[ilep1].id_HWW && leptons[ilep2].id_T) || (leptons[ilep2].id_HWW && leptons[ilep1].id_T);
+    //dilep.id_HWWHWW = leptons[ilep1].id_HWW && leptons[ilep2].id_HWW;
+    //dilep.iso_LL = leptons[ilep1].iso_L && leptons[ilep2].iso_L;
+    //dilep.iso_LT = (leptons[ilep1].iso_L && leptons[ilep2].iso_T) || (leptons[ilep2].iso_L && leptons[ilep1].iso_T);
+    //dilep.iso_LHWW = (leptons[ilep1].iso_L && leptons[ilep2].iso_HWW) || (leptons[ilep2].iso_L && leptons[ilep1].iso_HWW);
+    //dilep.iso_TL = (leptons[ilep1].iso_T && leptons[ilep2].iso_L) || (leptons[ilep2].iso_T && leptons[ilep1].iso_L);
+    //dilep.iso_TT = leptons[ilep1].iso_T && leptons[ilep2].iso_T;
+    //dilep.iso_THWW = (leptons[ilep1].iso_T && leptons[ilep2].iso_HWW) || (leptons[ilep2].iso_T && leptons[ilep1].iso_HWW);
+    //dilep.iso_HWWL = (leptons[ilep1].iso_HWW && leptons[ilep2].iso_L) || (leptons[ilep2].iso_HWW && leptons[ilep1].iso_L);
+    //dilep.iso_HWWT = (leptons[ilep1].iso_HWW && leptons[ilep2].iso_T) || (leptons[ilep2].iso_HWW && leptons[ilep1].iso_T);
+    //dilep.iso_HWWHWW = leptons[ilep1].iso_HWW && leptons[ilep2].iso_HWW;
+    dilep.DR_l_l = ll_DR(ilep1, ilep2);
+    dilep.DPhi_l_l = fabs(ll_DPhi(ilep1, ilep2));
+    dilep.ht_l_l = leptons[ilep1].p4.Pt() + leptons[ilep2].p4.Pt();
+    dilep.gen_matched = leptons[ilep1].gen_matched && leptons[ilep2].gen_matched;
+    dilep.gen_p4 = dilep.gen_matched ? leptons[ilep1].gen_p4 + leptons[ilep2].gen_p4 : null_p4;
+    dilep.gen_DR = dilep.gen_matched ? ROOT::Math::VectorUtil::DeltaR(dilep.p4, dilep.gen_p4) : -1.;
+    dilep.gen_DPtOverPt = dilep.gen_matched ? (dilep.p4.Pt() - dilep.gen_p4.Pt()) / dilep.p4.Pt() : -10.;
+
+    return dilep;
+}
+
+HH::Dijet HHAnalyzer::makeDijet(unsigned int ijet1, unsigned int ijet2) {
+    LorentzVector null_p4(0., 0., 0., 0.);
+    HH::Dijet myjj;
+    myjj.p4 = (jets_soa.fourVector(ijet1) + jets_soa.fourVector(ijet2)).p4();
+    myjj.idxs = std::make_pair(jets[ijet1].idx, jets[ijet2].idx);
+    myjj.ijet1 = ijet1;
+    myjj.ijet2 = ijet2;
+    //myjj.jid_LL = jets[ijet1].id_L && jets[ijet2].id_L;
+    //myjj.jid_TT = jets[ijet1].id_T && jets[ijet2].id_T;
+    //myjj.jid_TLVTLV = jets[ijet1].id_TLV && jets[ijet2].id_TLV;
+    //myjj.btag_LL = jets[ijet1].btag_L && jets[ijet2].btag_L;
+    //myjj.btag_LM = (jets[ijet1].btag_L && jets[ijet2].btag_M) || (jets[ijet2].btag_L && jets[ijet1].btag_M);
+    //myjj.btag_LT = (jets[ijet1].btag_L && jets[ijet2].btag_T) || (jets[ijet2].btag_L && jets[ijet1].btag_T);
+    //myjj.btag_ML = (jets[ijet1].btag_M && jets[ijet2].btag_L) || (jets[ijet2].btag_M && jets[ijet1].btag_L);
+    myjj.btag_MM = jets[ijet1].btag_M && jets[ijet2].btag_M;
+    //myjj.btag_MT = (jets[ijet1].btag_M && jets[ijet2].btag_T) || (jets[ijet2].btag_M && jets[ijet1].btag_T);
+    //myjj.btag_TL = (jets[ijet1].btag_T && jets[ijet2].btag_L) || (jets[ijet2].btag_T && jets[ijet1].btag_L);
+    //myjj.btag_TM = (jets[ijet1].btag_T && jets[ijet2].btag_M) || (jets[ijet2].btag_T && jets[ijet1].btag_M);
+    //myjj.btag_TT = jets[ijet1].btag_T && jets[ijet2].btag_T;
+    myjj.sumCSV = jets[ijet1].CSV + jets[ijet2].CSV;
+    myjj.sumCMVAv2 = jets[ijet1].CMVAv2 + jets[ijet2].CMVAv2;
+    myjj.DR_j_j = jj_DR(pairing_position[ijet1], pairing_position[ijet2]);
+    myjj.DPhi_j_j = fabs(jj_DPhi(pairing_position[ijet1], pairing_position[ijet2]));
+    myjj.ht_j_j = jets[ijet1].p4.Pt() + jets[ijet2].p4.Pt();
+    myjj.gen_matched_bbPartons = jets[ijet1].gen_matched_bParton && jets[ijet2].gen_matched_bParton; 
+    myjj.gen_matched_bbHadrons = jets[ijet1].gen_matched_bHadron && jets[ijet2].gen_matched_bHadron; 
+    myjj.gen_matched = jets[ijet1].gen_matched && jets[ijet2].gen_matched;
+    myjj.gen_p4 = myjj.gen_matched ? jets[ijet1].gen_p4 + jets[ijet2].gen_p4 : null_p4;
+    myjj.gen_DR = myjj.gen_matched ? ROOT::Math::VectorUtil::DeltaR(myjj.p4, myjj.gen_p4) : -1.;
+    myjj.gen_DPtOverPt = myjj.gen_matched ? (myjj.p4.Pt() - myjj.gen_p4.Pt()) / myjj.p4.Pt() : -10.;
+    myjj.gen_bb = (jets[ijet1].gen_b && jets[ijet2].gen_b);
+    myjj.gen_bc = (jets[ijet1].gen_b && jets[ijet2].gen_c) || (jets[ijet1].gen_c && jets[ijet2].gen_b);
+    myjj.gen_bl = (jets[ijet1].gen_b && jets[ijet2].gen_l) || (jets[ijet1].gen_l && jets[ijet2].gen_b);
+    myjj.gen_cc = (jets[ijet1].gen_c && jets[ijet2].gen_c);
+    myjj.gen_cl = (jets[ijet1].gen_c && jets[ijet2].gen_l) || (jets[ijet1].gen_l && jets[ijet2].gen_c);
+    myjj.gen_ll = (jets[ijet1].gen_l && jets[ijet2].gen_l);
+
+    return myjj;
+}
 
+HH::MELAInputs HHAnalyzer::makeMELAInputs(unsigned int illmet, unsigned int ijet1, unsigned int ijet2) {
+    // From the jets, as the dijet may not be built yet
+    const HH::DileptonMetCandidate& myllmet = llmet[illmet];
+    const HH::Dilepton& myll = ll[myllmet.ill];
+    HH::MELAInputs inputs;
+    inputs.llmet = HH::CartesianP4(myllmet.p4);
+    inputs.ll = HH::CartesianP4(myll.p4);
+    inputs.jj = HH::CartesianP4((jets_soa.fourVector(ijet1) + jets_soa.fourVector(ijet2)).p4());
+    inputs.lep1 = HH::CartesianP4(leptons_soa.px[myll.ilep1], leptons_soa.py[myll.ilep1], leptons_soa.pz[myll.ilep1], leptons_soa.E[myll.ilep1]);
+    inputs.lep2 = HH::CartesianP4(leptons_soa.px[myll.ilep2], leptons_soa.py[myll.ilep2], leptons_soa.pz[myll.ilep2], leptons_soa.E[myll.ilep2]);
+    inputs.jet1 = HH::CartesianP4(jets_soa.px[ijet1], jets_soa.py[ijet1], jets_soa.pz[ijet1], jets_soa.E[ijet1]);
+    inputs.jet2 = HH::CartesianP4(jets_soa.px[ijet2], jets_soa.py[ijet2], jets_soa.pz[ijet2], jets_soa.E[ijet2]);
+    return inputs;
+}
+
+HH::MT2Input HHAnalyzer::makeMT2Input(unsigned int illmet, unsigned int ijet1, unsigned int ijet2) {
+    // The two b jets are the visible particles, the leptons are part of the invisible system together with the met
+    const HH::DileptonMetCandidate& myllmet = llmet[illmet];
+    const HH::Dilepton& myll = ll[myllmet.ill];
+    const LorentzVector& mymet = met[myllmet.imet].p4;
+    HH::MT2Input input;
+    input.mVis1 = jets[ijet1].p4.M();
+    input.pxVis1 = jets_soa.px[ijet1];
+    input.pyVis1 = jets_soa.py[ijet1];
+    input.mVis2 = jets[ijet2].p4.M();
+    input.pxVis2 = jets_soa.px[ijet2];
+    input.pyVis2 = jets_soa.py[ijet2];
+    input.pxMiss = leptons_soa.px[myll.ilep1] + leptons_soa.px[myll.ilep2] + mymet.Px();
+    input.pyMiss = leptons_soa.py[myll.ilep1] + leptons_soa.py[myll.ilep2] + mymet.Py();
+    input.mInvis1 = leptons[myll.ilep1].p4.M();
+    input.mInvis2 = leptons[myll.ilep2].p4.M();
+    return input;
+}
+
+HH::DileptonMetDijet HHAnalyzer::makeDileptonMetDijet(unsigned int illmet, unsigned int ijj) {
+    LorentzVector null_p4(0., 0., 0., 0.);
+    const HH::DileptonMetCandidate& myllmet = llmet[illmet];
+    unsigned int imet = myllmet.imet;
+    unsigned int ill = myllmet.ill;
+    unsigned int ijet1 = jj[ijj].ijet1;
+    unsigned int ijet2 = jj[ijj].ijet2;
+    unsigned int ilep1 = ll[ill].ilep1;
+    unsigned int ilep2 = ll[ill].ilep2;
+    HH::DileptonMetDijet myllmetjj;
+    // copy of the ll content
+    myllmetjj.ilep1 = ilep1;
+    myllmetjj.ilep2 = ilep2;
+    myllmetjj.isOS = ll[ill].isOS;
+    myllmetjj.isPlusMinus = ll[ill].isPlusMinus;
+    myllmetjj.isMinusPlus = ll[ill].isMinusPlus;
+    myllmetjj.isMuMu = ll[ill].isMuMu;
+    myllmetjj.isElEl = ll[ill].isElEl;
+    myllmetjj.isElMu = ll[ill].isElMu;
+    myllmetjj.isMuEl = ll[ill].isMuEl;
+    myllmetjj.isSF = ll[ill].isSF;
+    myllmetjj.DR_l_l = ll[ill].DR_l_l;
+    myllmetjj.DPhi_l_l = ll[ill].DPhi_l_l;
+    myllmetjj.ht_l_l = ll[ill].ht_l_l;
+    myllmetjj.trigger_efficiency = ll[ill].trigger_efficiency;
+    myllmetjj.trigger_efficiency_downVariated = ll[ill].trigger_efficiency_downVariated;
+    myllmetjj.trigger_efficiency_upVariated = ll[ill].trigger_efficiency_upVariated;
+    // copy of the met content
+    myllmetjj.imet = imet;
+    myllmetjj.isNoHF = met[imet].isNoHF;
+    // copy of the jj content
+    myllmetjj.ijet1 = ijet1;
+    myllmetjj.ijet2 = ijet2;
+    myllmetjj.btag_MM = jj[ijj].btag_MM;
+    myllmetjj.sumCSV = jj[ijj].sumCSV;
+    myllmetjj.sumCMVAv2 = jj[ijj].sumCMVAv2;
+    myllmetjj.DR_j_j = jj[ijj].DR_j_j;
+    myllmetjj.DPhi_j_j = jj[ijj].DPhi_j_j;
+    myllmetjj.ht_j_j = jj[ijj].ht_j_j;
+    myllmetjj.gen_matched_bbPartons = jj[ijj].gen_matched_bbPartons;
+    myllmetjj.gen_matched_bbHadrons = jj[ijj].gen_matched_bbHadrons;
+    myllmetjj.gen_bb = jj[ijj].gen_bb;
+    myllmetjj.gen_bc = jj[ijj].gen_bc;
+    myllmetjj.gen_bl = jj[ijj].gen_bl;
+    myllmetjj.gen_cc = jj[ijj].gen_cc;
+    myllmetjj.gen_cl = jj[ijj].gen_cl;
+    myllmetjj.gen_ll = jj[ijj].gen_ll;
+    // content specific to the ll + met system
+    myllmetjj.DPhi_ll_met = myllmet.DPhi_ll_met;
+    myllmetjj.minDPhi_l_met = myllmet.minDPhi_l_met;
+    myllmetjj.maxDPhi_l_met = myllmet.maxDPhi_l_met;
+    myllmetjj.MT = myllmet.MT;
+    myllmetjj.MT_formula = myllmet.MT_formula;
+    myllmetjj.projectedMet = myllmet.projectedMet;
+    // four-vectors
+    // The sums are done on the cartesian components, which are only computed once for each object
+    HH::FourVector lep1 = leptons_soa.fourVector(ilep1);
+    HH::FourVector lep2 = leptons_soa.fourVector(ilep2);
+    HH::FourVector jet1 = jets_soa.fourVector(ijet1);
+    HH::FourVector jet2 = jets_soa.fourVector(ijet2);
+    HH::FourVector mymet(met[imet].p4);
+    myllmetjj.p4 = ((lep1 + lep2) + (jet1 + jet2) + mymet).p4();
+    myllmetjj.lep1_p4 = leptons[ilep1].p4;
+    myllmetjj.lep2_p4 = leptons[ilep2].p4;
+    myllmetjj.jet1_p4 = jets[ijet1].p4;
+    myllmetjj.jet2_p4 = jets[ijet2].p4;
+    myllmetjj.met_p4 = met[imet].p4;
+    myllmetjj.ll_p4 = ll[ill].p4;
+    myllmetjj.jj_p4 = jj[ijj].p4;
+    // gen info
+    myllmetjj.gen_matched = ll[ill].gen_matched && jj[ijj].gen_matched && met[imet].gen_matched;
+    myllmetjj.gen_p4 = myllmetjj.gen_matched ? (HH::FourVector(ll[ill].gen_p4) + HH::FourVector(jj[ijj].gen_p4) + HH::FourVector(met[imet].gen_p4)).p4() : null_p4;
+    myllmetjj.gen_DR = myllmetjj.gen_matched ? ROOT::Math::VectorUtil::DeltaR(myllmetjj.p4, myllmetjj.gen_p4) : -1.;
+    myllmetjj.gen_DPhi = myllmetjj.gen_matched ? fabs(ROOT::Math::VectorUtil::DeltaPhi(myllmetjj.p4, myllmetjj.gen_p4)) : -1.;
+    myllmetjj.gen_DPtOverPt = myllmetjj.gen_matched ? (myllmetjj.p4.Pt() - myllmetjj.gen_p4.Pt()) / myllmetjj.p4.Pt() : -10.;
+    myllmetjj.gen_lep1_p4 = leptons[ilep1].gen_p4;
+    myllmetjj.gen_lep2_p4 = leptons[ilep2].gen_p4;
+    myllmetjj.gen_jet1_p4 = jets[ijet1].gen_p4;
+    myllmetjj.gen_jet2_p4 = jets[ijet2].gen_p4;
+    myllmetjj.gen_met_p4 = met[imet].gen_p4;
+    myllmetjj.gen_ll_p4 = ll[ill].gen_p4;
+    myllmetjj.gen_jj_p4 = jj[ijj].gen_p4;
+    // content specific to the jj + met system
+    // NB: computed for the first time here, no intermediate jjmet collection
+    myllmetjj.DPhi_jj_met = fabs(ROOT::Math::VectorUtil::DeltaPhi(jj[ijj].p4, met[imet].p4));
+    myllmetjj.minDPhi_j_met = std::min(fabs(ROOT::Math::VectorUtil::DeltaPhi(jets[jj[ijj].ijet1].p4, met[imet].p4)), fabs(ROOT::Math::VectorUtil::DeltaPhi(jets[jj[ijj].ijet2].p4, met[imet].p4)));
+    myllmetjj.maxDPhi_j_met = std::max(fabs(ROOT::Math::VectorUtil::DeltaPhi(jets[jj[ijj].ijet1].p4, met[imet].p4)), fabs(ROOT::Math::VectorUtil::DeltaPhi(jets[jj[ijj].ijet2].p4, met[imet].p4)));
+    // content specific to the full system
+    float DR_j1l1, DR_j1l2, DR_j2l1, DR_j2l2;
+    DR_j1l1 = jl_DR(ijet1, ilep1);
+    DR_j1l2 = jl_DR(ijet1, ilep2);
+    DR_j2l1 = jl_DR(ijet2, ilep1);
+    DR_j2l2 = jl_DR(ijet2, ilep2);
+    myllmetjj.maxDR_l_j = std::max({DR_j1l1, DR_j1l2, DR_j2l1, DR_j2l2});
+    myllmetjj.minDR_l_j = std::min({DR_j1l1, DR_j1l2, DR_j2l1, DR_j2l2});
+    myllmetjj.DR_ll_jj = ROOT::Math::VectorUtil::DeltaR(ll[ill].p4, jj[ijj].p4);
+    myllmetjj.DPhi_ll_jj = fabs(ROOT::Math::VectorUtil::DeltaPhi(ll[ill].p4, jj[ijj].p4));
+    myllmetjj.DR_llmet_jj = ROOT::Math::VectorUtil::DeltaR(myllmet.p4, jj[ijj].p4);
+    myllmetjj.DPhi_llmet_jj = fabs(ROOT::Math::VectorUtil::DeltaPhi(myllmet.p4, jj[ijj].p4));
+    myllmetjj.MT_fullsystem = myllmetjj.p4.Mt();
+    // cosThetaStar_CS, the MELA angles and MT2 are filled in analyze, in one batch for the candidates which can be tried
+
+    return myllmetjj;
 }
 
 void HHAnalyzer::endJob(MetadataManager& metadata) {
@@ -1329,5 +1582,21 @@ void HHAnalyzer::endJob(MetadataManager& metadata) {
         metadata.add(this->m_name + "_count_has2leptons_elmu_1llmetjj_2btagM", count_has2leptons_elmu_1llmetjj_2btagM);
         metadata.add(this->m_name + "_count_has2leptons_muel_1llmetjj_2btagM", count_has2leptons_muel_1llmetjj_2btagM);
         metadata.add(this->m_name + "_count_has2leptons_mumu_1llmetjj_2btagM", count_has2leptons_mumu_1llmetjj_2btagM);
+        metadata.add(this->m_name + "_count_jetPairingTruncated", static_cast<float>(count_jetPairingTruncated));
+        metadata.add(this->m_name + "_count_jetPairingDroppedJets", static_cast<float>(count_jetPairingDroppedJets));
+        metadata.add(this->m_name + "_count_bestJetPairsOverflow", static_cast<float>(count_bestJetPairsOverflow));
+        metadata.add(this->m_name + "_count_mt2Evaluations", static_cast<float>(count_mt2Evaluations));
+        metadata.add(this->m_name + "_count_mt2Iterations", static_cast<float>(count_mt2Iterations));
+
+        // Differences between the fast and the exact kinematic functions, filled in validation mode
+        for (const auto& validation: m_mathValidation) {
+            const std::string prefix = this->m_name + "_kinematicsMathValidation_" + validation.first;
+            metadata.add(prefix + "_entries", float(validation.second.entries));
+            metadata.add(prefix + "_mismatches", float(validation.second.mismatches));
+            metadata.add(prefix + "_maxDifference", float(validation.second.max_difference));
+            metadata.add(prefix + "_maxDifferenceExactValue", float(validation.second.max_difference_exact));
+            for (size_t i = 0; i < HH::fastmath::Validation::n_bins; i++)
+                metadata.add(prefix + "_difference_" + HH::fastmath::Validation::binLabel(i), float(validation.second.counts[i]));
+        }
     }
 }
@@ -0,0 +1,67 @@
+#include <cp3_llbb/HHAnalysis/interface/HLTObjectFlags.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace HH {
+
+uint64_t HLTObjectFlags::filterMask(const std::vector<std::string>& filters) {
+    uint64_t mask = 0;
+    for (const auto& filter: filters) {
+        auto it = m_filter_bits.find(filter);
+        if (it == m_filter_bits.end()) {
+            if (m_filter_bits.size() == 64)
+                throw std::length_error("Too many HLT filters registered");
+            it = m_filter_bits.emplace(filter, uint64_t(1) << m_filter_bits.size()).first;
+        }
+        mask |= it->second;
+    }
+    return mask;
+}
+
+void HLTObjectFlags::build(const std::vector<std::vector<std::string>>& object_paths, const std::vector<std::vector<std::string>>& object_filters) {
+    m_object_paths = &object_paths;
+    m_object_filters = &object_filters;
+
+    size_t n_objects = std::max(object_paths.size(), object_filters.size());
+    m_cached.assign(n_objects, 0);
+    // Never shrunk, to keep the capacity of the path ID buffers
+    if (m_paths.size() < n_objects)
+        m_paths.resize(n_objects);
+    m_filters.resize(n_objects);
+}
+
+const std::vector<uint32_t>& HLTObjectFlags::paths(size_t i) {
+    std::vector<uint32_t>& ids = m_paths[i];
+    if (m_cached[i] & Paths)
+        return ids;
+    m_cached[i] |= Paths;
+
+    ids.clear();
+    for (const auto& path: (*m_object_paths)[i]) {
+        // Look up first: emplace would build a node for every known path
+        auto it = m_path_ids.find(path);
+        if (it == m_path_ids.end())
+            it = m_path_ids.emplace(path, m_path_ids.size()).first;
+        ids.push_back(it->second);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+uint64_t HLTObjectFlags::filters(size_t i) {
+    if (m_cached[i] & Filters)
+        return m_filters[i];
+    m_cached[i] |= Filters;
+
+    uint64_t bits = 0;
+    for (const auto& filter: (*m_object_filters)[i]) {
+        auto it = m_filter_bits.find(filter);
+        if (it != m_filter_bits.end())
+            bits |= it->second;
+    }
+    m_filters[i] = bits;
+    return bits;
+}
+
+}
@@ -0,0 +1,259 @@
+#include <cp3_llbb/HHAnalysis/interface/MT2Engine.h>
+#include <cp3_llbb/HHAnalysis/interface/lester_mt2_bisect.h>
+
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+namespace HH {
+
+namespace {
+
+    const unsigned int maxAttempts = 10000;
+
+    // Coefficients of the ellipse c_xx x^2 + 2 c_xy x y + c_yy y^2 + 2 c_x x + 2 c_y y + c = 0 and the determinant of its
+    // conic matrix, for a parent of mass sqrt(mSq) (same expressions as asymm_mt2_lester_bisect::helper)
+    struct Ellipse {
+        double c_xx, c_yy, c_xy, c_x, c_y, c, det;
+    };
+
+    inline Ellipse makeEllipse(const double mSq, const double mtSq, const double tx, const double ty, const double mqSq, const double pxmiss, const double pymiss) {
+        const double txSq = tx*tx;
+        const double tySq = ty*ty;
+        const double pxmissSq = pxmiss*pxmiss;
+        const double pymissSq = pymiss*pymiss;
+
+        Ellipse e;
+        e.c_xx = +4.0* mtSq + 4.0* tySq;
+        e.c_yy = +4.0* mtSq + 4.0* txSq;
+        e.c_xy = -4.0* tx*ty;
+        e.c_x  = -4.0* mtSq*pxmiss - 2.0* mqSq*tx + 2.0* mSq*tx - 2.0* mtSq*tx  +
+               4.0* pymiss*tx*ty - 4.0* pxmiss*tySq;
+        e.c_y  = -4.0* mtSq*pymiss - 4.0* pymiss*txSq - 2.0* mqSq*ty + 2.0* mSq*ty - 2.0* mtSq*ty +
+               4.0* pxmiss*tx*ty;
+        e.c =   - mqSq*mqSq + 2*mqSq*mSq - mSq*mSq + 2*mqSq*mtSq + 2*mSq*mtSq - mtSq*mtSq +
+                4.0* mtSq*pxmissSq + 4.0* mtSq*pymissSq + 4.0* mqSq*pxmiss*tx -
+                4.0* mSq*pxmiss*tx + 4.0* mtSq*pxmiss*tx + 4.0* mqSq*txSq +
+                4.0* pymissSq*txSq + 4.0* mqSq*pymiss*ty - 4.0* mSq*pymiss*ty +
+                4.0* mtSq*pymiss*ty - 8.0* pxmiss*pymiss*tx*ty + 4.0* mqSq*tySq +
+                4.0* pxmissSq*tySq;
+        e.det = (2.0*e.c_x*e.c_xy*e.c_y + e.c*e.c_xx*e.c_yy - e.c_yy*e.c_x*e.c_x - e.c*e.c_xy*e.c_xy - e.c_xx*e.c_y*e.c_y);
+        return e;
+    }
+
+    inline double lesterFactor(const Ellipse& e1, const Ellipse& e2) {
+        return e1.c_xx*e1.c_yy*e2.c + 2.0*e1.c_xy*e1.c_y*e2.c_x - 2.0*e1.c_x*e1.c_yy*e2.c_x + e1.c*e1.c_yy*e2.c_xx - 2.0*e1.c*e1.c_xy*e2.c_xy + 2.0*e1.c_x*e1.c_y*e2.c_xy + 2.0*e1.c_x*e1.c_xy*e2.c_y - 2.0*e1.c_xx*e1.c_y*e2.c_y + e1.c*e1.c_xx*e2.c_yy - e2.c_yy*(e1.c_x*e1.c_x) - e2.c*(e1.c_xy*e1.c_xy) - e2.c_xx*(e1.c_y*e1.c_y);
+    }
+
+    // Lester::ellipsesAreDisjoint without branches (hence the bitwise operators): 0 for overlapping ellipses, 1 for disjoint ellipses, 2 if the test
+    // cannot be done because the ellipses are degenerate (where Lester::ellipsesAreDisjoint throws)
+    inline int32_t ellipsesAreDisjoint(const Ellipse& e1, const Ellipse& e2) {
+        const bool equal = (e1.c_xx == e2.c_xx) & (e1.c_yy == e2.c_yy) & (e1.c_xy == e2.c_xy) & (e1.c_x == e2.c_x) & (e1.c_y == e2.c_y) & (e1.c == e2.c);
+
+        const double coeffLamPow3 = e1.det;
+        const double coeffLamPow2 = lesterFactor(e1, e2);
+        const double coeffLamPow1 = lesterFactor(e2, e1);
+        const double coeffLamPow0 = e2.det;
+
+        // Divide by the largest of the two extreme coefficients
+        const bool normal_order = std::abs(coeffLamPow3) >= std::abs(coeffLamPow0);
+        const double c3 = normal_order ? coeffLamPow3 : coeffLamPow0;
+        const double c2 = normal_order ? coeffLamPow2 : coeffLamPow1;
+        const double c1 = normal_order ? coeffLamPow1 : coeffLamPow2;
+        const double c0 = normal_order ? coeffLamPow0 : coeffLamPow3;
+
+        const double a = c2 / c3;
+        const double b = c1 / c3;
+        const double c = c0 / c3;
+
+        const double thing1 = -3.0*b + a*a;
+        const double thing2 = -27.0*c*c + 18.0*c*a*b + a*a*b*b - 4.0*a*a*a*c - 4.0*b*b*b;
+        // Written as !(x <= 0) rather than x > 0, to handle NaNs exactly as Lester::__private_ellipsesAreDisjoint
+        const bool disjoint = !(thing1 <= 0) & !(thing2 <= 0) & (((a >= 0) & (3.0*a*c + b*a*a - 4.0*b*b < 0)) | (a < 0));
+
+        const bool degenerate = (c3 == 0);
+        return (! equal) * (2 * degenerate + (! degenerate) * disjoint);
+    }
+}
+
+MT2Engine::MT2Engine(double precision, double threshold):
+    m_precision(precision), m_threshold(threshold) {
+    // The algorithm is the one of asymm_mt2_lester_bisect, see http://arxiv.org/abs/1411.4312
+    asymm_mt2_lester_bisect::disableCopyrightMessage();
+}
+
+void MT2Engine::compute(const std::vector<MT2Input>& inputs, std::vector<MT2Result>& results) {
+    const size_t n = inputs.size();
+    results.assign(n, {0., 0});
+
+    for (auto* v: {&m_mLower, &m_mUpper, &m_trialM, &m_trialMSq, &m_msSq, &m_sx, &m_sy, &m_mpSq, &m_mtSq, &m_tx, &m_ty, &m_mqSq, &m_pxMiss, &m_pyMiss})
+        v->resize(n);
+    m_index.resize(n);
+    m_phase.resize(n);
+    m_goLow.resize(n);
+    m_attempts.resize(n);
+    m_iterations.resize(n);
+    m_disjoint.resize(n);
+
+    m_n_active = 0;
+    for (size_t k = 0; k < n; k++) {
+        MT2Input in = inputs[k];
+        // Side 1 must be the one with the smallest minimal parent mass
+        if (in.mVis1 + in.mInvis1 > in.mVis2 + in.mInvis2) {
+            std::swap(in.mVis1, in.mVis2);
+            std::swap(in.pxVis1, in.pxVis2);
+            std::swap(in.pyVis1, in.pyVis2);
+            std::swap(in.mInvis1, in.mInvis2);
+        }
+
+        const double mMin = in.mVis2 + in.mInvis2;
+
+        const double msSq = in.mVis1*in.mVis1;
+        const double mpSq = in.mInvis1*in.mInvis1;
+        const double mtSq = in.mVis2*in.mVis2;
+        const double mqSq = in.mInvis2*in.mInvis2;
+
+        const double sSq = in.pxVis1*in.pxVis1 + in.pyVis1*in.pyVis1;
+        const double tSq = in.pxVis2*in.pxVis2 + in.pyVis2*in.pyVis2;
+        const double pMissSq = in.pxMiss*in.pxMiss + in.pyMiss*in.pyMiss;
+        const double massSqSum = msSq + mtSq + mpSq + mqSq;
+        const double scaleSq = (massSqSum + sSq + tSq + pMissSq)/8.0;
+
+        if (scaleSq == 0)
+            continue;
+
+        size_t i = m_n_active++;
+        m_index[i] = k;
+        m_phase[i] = Phase::Bracketing;
+        m_goLow[i] = true;
+        m_attempts[i] = 0;
+        m_iterations[i] = 0;
+        m_mLower[i] = mMin;
+        m_mUpper[i] = mMin + sqrt(scaleSq);
+        m_msSq[i] = msSq;
+        m_sx[i] = in.pxVis1;
+        m_sy[i] = in.pyVis1;
+        m_mpSq[i] = mpSq;
+        m_mtSq[i] = mtSq;
+        m_tx[i] = in.pxVis2;
+        m_ty[i] = in.pyVis2;
+        m_mqSq[i] = mqSq;
+        m_pxMiss[i] = in.pxMiss;
+        m_pyMiss[i] = in.pyMiss;
+    }
+
+    while (m_n_active > 0) {
+        // Trial mass of each lane, or its result if the bisection is over
+        for (size_t i = 0; i < m_n_active;) {
+            double& mLower = m_mLower[i];
+            double& mUpper = m_mUpper[i];
+            if (m_phase[i] == Phase::Bracketing) {
+                // MT2 is always above the lower end of the search range
+                if (m_threshold > 0 && mLower >= m_threshold) {
+                    finish(i, mLower, results);
+                    continue;
+                }
+                m_trialM[i] = mUpper;
+            } else {
+                // In threshold mode, the precision is not used: the bisection goes on until the interval is on one side of the threshold
+                const bool done = (m_threshold > 0) ? (mLower >= m_threshold || mUpper <= m_threshold) : (m_precision > 0 && mUpper - mLower <= m_precision);
+                if (done) {
+                    finish(i, (mLower + mUpper) / 2.0, results);
+                    continue;
+                }
+                const double trialM = m_goLow[i] ? (mLower*15 + mUpper)/16 : (mUpper + mLower)/2.0;
+                if (trialM <= mLower || trialM >= mUpper) {
+                    // Numerical precision limit: the interval can no longer be bisected
+                    finish(i, trialM, results);
+                    continue;
+                }
+                m_trialM[i] = trialM;
+            }
+            m_trialMSq[i] = m_trialM[i] * m_trialM[i];
+            i++;
+        }
+
+        testEllipses(m_n_active);
+
+        for (size_t i = 0; i < m_n_active;) {
+            m_iterations[i]++;
+            const int32_t disjoint = m_disjoint[i];
+            if (m_phase[i] == Phase::Bracketing) {
+                m_attempts[i]++;
+                if (disjoint == 2) {
+                    finish(i, ERROR, results);
+                    continue;
+                }
+                if (! disjoint) {
+                    m_phase[i] = Phase::Bisecting;
+                } else if (m_attempts[i] >= maxAttempts) {
+                    std::cerr << "MT2 algorithm failed to find upper bound to MT2" << std::endl;
+                    finish(i, ERROR, results);
+                    continue;
+                } else {
+                    m_mUpper[i] *= 2;
+                }
+            } else {
+                if (disjoint == 2) {
+                    // The ellipses became degenerate, which can only happen at the bottom of the search range
+                    finish(i, m_mLower[i], results);
+                    continue;
+                }
+                if (disjoint) {
+                    m_mLower[i] = m_trialM[i];
+                    m_goLow[i] = false;
+                } else {
+                    m_mUpper[i] = m_trialM[i];
+                }
+            }
+            i++;
+        }
+    }
+
+    if (m_threshold > 0) {
+        for (auto& result: results) {
+            if (result.MT2 != ERROR)
+                result.MT2 = (result.MT2 >= m_threshold) ? ABOVE_THRESHOLD : BELOW_THRESHOLD;
+        }
+    }
+}
+
+void MT2Engine::testEllipses(size_t n) {
+    const double* trialMSq = m_trialMSq.data();
+    const double* msSq = m_msSq.data();
+    const double* sx = m_sx.data();
+    const double* sy = m_sy.data();
+    const double* mpSq = m_mpSq.data();
+    const double* mtSq = m_mtSq.data();
+    const double* tx = m_tx.data();
+    const double* ty = m_ty.data();
+    const double* mqSq = m_mqSq.data();
+    const double* pxMiss = m_pxMiss.data();
+    const double* pyMiss = m_pyMiss.data();
+    int32_t* disjoint = m_disjoint.data();
+
+    for (size_t i = 0; i < n; i++) {
+        const Ellipse side1 = makeEllipse(trialMSq[i], msSq[i], -sx[i], -sy[i], mpSq[i], 0, 0);
+        const Ellipse side2 = makeEllipse(trialMSq[i], mtSq[i], +tx[i], +ty[i], mqSq[i], pxMiss[i], pyMiss[i]);
+        disjoint[i] = ellipsesAreDisjoint(side1, side2);
+    }
+}
+
+void MT2Engine::finish(size_t i, double MT2, std::vector<MT2Result>& results) {
+    results[m_index[i]] = {MT2, m_iterations[i]};
+
+    const size_t last = --m_n_active;
+    if (i == last)
+        return;
+
+    std::swap(m_index[i], m_index[last]);
+    std::swap(m_phase[i], m_phase[last]);
+    std::swap(m_goLow[i], m_goLow[last]);
+    std::swap(m_attempts[i], m_attempts[last]);
+    std::swap(m_iterations[i], m_iterations[last]);
+    std::swap(m_disjoint[i], m_disjoint[last]);
+    for (auto* v: {&m_mLower, &m_mUpper, &m_trialM, &m_trialMSq, &m_msSq, &m_sx, &m_sy, &m_mpSq, &m_mtSq, &m_tx, &m_ty, &m_mqSq, &m_pxMiss, &m_pyMiss})
+        std::swap((*v)[i], (*v)[last]);
+}
+
+}
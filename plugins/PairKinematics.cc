@@ -0,0 +1,163 @@
+#include <cp3_llbb/HHAnalysis/interface/PairKinematics.h>
+
+#include <cmath>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace HH {
+
+void KinematicsSoA::clear() {
+    pt.clear();
+    eta.clear();
+    phi.clear();
+    E.clear();
+    px.clear();
+    py.clear();
+    pz.clear();
+}
+
+void KinematicsSoA::push_back(const LorentzVector& p4) {
+    pt.push_back(p4.Pt());
+    eta.push_back(p4.Eta());
+    phi.push_back(p4.Phi());
+    E.push_back(p4.E());
+    px.push_back(p4.Px());
+    py.push_back(p4.Py());
+    pz.push_back(p4.Pz());
+}
+
+namespace {
+
+    // DeltaPhi and DeltaR between one object and the objects [begin, end[ of a collection.
+    // As in ROOT::Math::VectorUtil, the differences are taken in single precision and the rest is done in double precision
+    void deltaPhiDeltaRRow(float a_eta, float a_phi, const float* b_eta, const float* b_phi, size_t begin, size_t end, float* dphi, float* dr) {
+        size_t j = begin;
+
+#if defined(__AVX__)
+        const __m256d pi = _mm256_set1_pd(M_PI);
+        const __m256d minus_pi = _mm256_set1_pd(-M_PI);
+        const __m256d two_pi = _mm256_set1_pd(2 * M_PI);
+        const __m128 va_eta = _mm_set1_ps(a_eta);
+        const __m128 va_phi = _mm_set1_ps(a_phi);
+        for (; j + 4 <= end; j += 4) {
+            __m256d d = _mm256_cvtps_pd(_mm_sub_ps(_mm_loadu_ps(b_phi + j), va_phi));
+            __m256d over = _mm256_cmp_pd(d, pi, _CMP_GT_OQ);
+            __m256d under = _mm256_cmp_pd(d, minus_pi, _CMP_LE_OQ);
+            d = _mm256_add_pd(_mm256_sub_pd(d, _mm256_and_pd(over, two_pi)), _mm256_and_pd(under, two_pi));
+            __m256d deta = _mm256_cvtps_pd(_mm_sub_ps(_mm_loadu_ps(b_eta + j), va_eta));
+            __m256d r = _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(d, d), _mm256_mul_pd(deta, deta)));
+            _mm_storeu_ps(dphi + j, _mm256_cvtpd_ps(d));
+            _mm_storeu_ps(dr + j, _mm256_cvtpd_ps(r));
+        }
+#elif defined(__SSE2__)
+        const __m128d pi = _mm_set1_pd(M_PI);
+        const __m128d minus_pi = _mm_set1_pd(-M_PI);
+        const __m128d two_pi = _mm_set1_pd(2 * M_PI);
+        const __m128 va_eta = _mm_set1_ps(a_eta);
+        const __m128 va_phi = _mm_set1_ps(a_phi);
+        for (; j + 2 <= end; j += 2) {
+            __m128 b_phi_2 = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(b_phi + j)));
+            __m128 b_eta_2 = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(b_eta + j)));
+            __m128d d = _mm_cvtps_pd(_mm_sub_ps(b_phi_2, va_phi));
+            __m128d over = _mm_cmpgt_pd(d, pi);
+            __m128d under = _mm_cmple_pd(d, minus_pi);
+            d = _mm_add_pd(_mm_sub_pd(d, _mm_and_pd(over, two_pi)), _mm_and_pd(under, two_pi));
+            __m128d deta = _mm_cvtps_pd(_mm_sub_ps(b_eta_2, va_eta));
+            __m128d r = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(d, d), _mm_mul_pd(deta, deta)));
+            _mm_storel_pi(reinterpret_cast<__m64*>(dphi + j), _mm_cvtpd_ps(d));
+            _mm_storel_pi(reinterpret_cast<__m64*>(dr + j), _mm_cvtpd_ps(r));
+        }
+#endif
+
+        for (; j < end; j++) {
+            double d = b_phi[j] - a_phi;
+            if (d > M_PI)
+                d -= 2 * M_PI;
+            else if (d <= -M_PI)
+                d += 2 * M_PI;
+            double deta = b_eta[j] - a_eta;
+            dphi[j] = d;
+            dr[j] = std::sqrt(d * d + deta * deta);
+        }
+    }
+
+    // Invariant mass and pt of the sum of one object with the objects [begin, end[ of a collection.
+    // The components are summed in single precision, as for the LorentzVector sum, the mass and pt are computed in double precision
+    void pairMassPtRow(const KinematicsSoA& a, size_t i, size_t begin, size_t end, float* mass, float* pt) {
+        size_t j = begin;
+        const float* px = a.px.data();
+        const float* py = a.py.data();
+        const float* pz = a.pz.data();
+        const float* E = a.E.data();
+
+#if defined(__AVX__)
+        const __m128 vx = _mm_set1_ps(px[i]);
+        const __m128 vy = _mm_set1_ps(py[i]);
+        const __m128 vz = _mm_set1_ps(pz[i]);
+        const __m128 ve = _mm_set1_ps(E[i]);
+        const __m256d sign = _mm256_set1_pd(-0.);
+        for (; j + 4 <= end; j += 4) {
+            __m256d x = _mm256_cvtps_pd(_mm_add_ps(vx, _mm_loadu_ps(px + j)));
+            __m256d y = _mm256_cvtps_pd(_mm_add_ps(vy, _mm_loadu_ps(py + j)));
+            __m256d z = _mm256_cvtps_pd(_mm_add_ps(vz, _mm_loadu_ps(pz + j)));
+            __m256d e = _mm256_cvtps_pd(_mm_add_ps(ve, _mm_loadu_ps(E + j)));
+            __m256d pt2 = _mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y));
+            __m256d m2 = _mm256_sub_pd(_mm256_mul_pd(e, e), _mm256_add_pd(pt2, _mm256_mul_pd(z, z)));
+            // Negative m2 gives a negative mass, as for LorentzVector::M()
+            __m256d m = _mm256_or_pd(_mm256_sqrt_pd(_mm256_andnot_pd(sign, m2)), _mm256_and_pd(sign, m2));
+            _mm_storeu_ps(mass + j, _mm256_cvtpd_ps(m));
+            _mm_storeu_ps(pt + j, _mm256_cvtpd_ps(_mm256_sqrt_pd(pt2)));
+        }
+#elif defined(__SSE2__)
+        const __m128 vx = _mm_set1_ps(px[i]);
+        const __m128 vy = _mm_set1_ps(py[i]);
+        const __m128 vz = _mm_set1_ps(pz[i]);
+        const __m128 ve = _mm_set1_ps(E[i]);
+        const __m128d sign = _mm_set1_pd(-0.);
+        auto load2 = [](const float* p) { return _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(p))); };
+        for (; j + 2 <= end; j += 2) {
+            __m128d x = _mm_cvtps_pd(_mm_add_ps(vx, load2(px + j)));
+            __m128d y = _mm_cvtps_pd(_mm_add_ps(vy, load2(py + j)));
+            __m128d z = _mm_cvtps_pd(_mm_add_ps(vz, load2(pz + j)));
+            __m128d e = _mm_cvtps_pd(_mm_add_ps(ve, load2(E + j)));
+            __m128d pt2 = _mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y));
+            __m128d m2 = _mm_sub_pd(_mm_mul_pd(e, e), _mm_add_pd(pt2, _mm_mul_pd(z, z)));
+            __m128d m = _mm_or_pd(_mm_sqrt_pd(_mm_andnot_pd(sign, m2)), _mm_and_pd(sign, m2));
+            _mm_storel_pi(reinterpret_cast<__m64*>(mass + j), _mm_cvtpd_ps(m));
+            _mm_storel_pi(reinterpret_cast<__m64*>(pt + j), _mm_cvtpd_ps(_mm_sqrt_pd(pt2)));
+        }
+#endif
+
+        for (; j < end; j++) {
+            float sx = px[i] + px[j];
+            float sy = py[i] + py[j];
+            float sz = pz[i] + pz[j];
+            float se = E[i] + E[j];
+            double x = sx, y = sy, z = sz, e = se;
+            double pt2 = x * x + y * y;
+            double m2 = e * e - (pt2 + z * z);
+            mass[j] = m2 >= 0 ? std::sqrt(m2) : -std::sqrt(-m2);
+            pt[j] = std::sqrt(pt2);
+        }
+    }
+}
+
+void computeDeltaPhiDeltaR(const KinematicsSoA& a, const KinematicsSoA& b, PairMatrix& dphi, PairMatrix& dr) {
+    dphi.resize(a.size(), b.size());
+    dr.resize(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        deltaPhiDeltaRRow(a.eta[i], a.phi[i], b.eta.data(), b.phi.data(), 0, b.size(), dphi.values.data() + i * b.size(), dr.values.data() + i * b.size());
+    }
+}
+
+void computePairMassPt(const KinematicsSoA& a, PairMatrix& mass, PairMatrix& pt) {
+    mass.resize(a.size(), a.size());
+    pt.resize(a.size(), a.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        pairMassPtRow(a, i, i + 1, a.size(), mass.values.data() + i * a.size(), pt.values.data() + i * a.size());
+    }
+}
+
+}
@@ -0,0 +1,61 @@
+#include <cp3_llbb/HHAnalysis/interface/Preselection.h>
+
+#include <cmath>
+
+namespace HH {
+
+size_t ObjectMask::count() const {
+    size_t n = 0;
+    for (uint64_t word: m_words)
+        n += __builtin_popcountll(word);
+    return n;
+}
+
+void ObjectMask::pack(const std::vector<uint8_t>& pass) {
+    m_size = pass.size();
+    m_words.assign((m_size + 63) / 64, 0);
+    for (size_t i = 0; i < m_size; i++)
+        m_words[i / 64] |= uint64_t(pass[i]) << (i % 64);
+}
+
+Preselection& Preselection::reset(size_t n) {
+    m_pass.assign(n, 1);
+    return *this;
+}
+
+Preselection& Preselection::kinematics(const std::vector<LorentzVector>& p4, float ptCut, float etaCut, const std::vector<float>* ptFactors/* = nullptr*/) {
+    const size_t n = m_pass.size();
+    uint8_t* pass = m_pass.data();
+    if (ptFactors) {
+        const float* factors = ptFactors->data();
+        for (size_t i = 0; i < n; i++)
+            pass[i] &= (p4[i].Pt() * factors[i] > ptCut) & (std::abs(p4[i].Eta()) < etaCut);
+    } else {
+        for (size_t i = 0; i < n; i++)
+            pass[i] &= (p4[i].Pt() > ptCut) & (std::abs(p4[i].Eta()) < etaCut);
+    }
+    return *this;
+}
+
+Preselection& Preselection::flag(const std::vector<bool>& flags) {
+    // std::vector<bool> is bit-packed, so this one is not vectorized
+    for (size_t i = 0; i < m_pass.size(); i++)
+        m_pass[i] &= flags[i];
+    return *this;
+}
+
+Preselection& Preselection::below(const std::vector<float>& values, float cut) {
+    const size_t n = m_pass.size();
+    uint8_t* pass = m_pass.data();
+    const float* v = values.data();
+    for (size_t i = 0; i < n; i++)
+        pass[i] &= (v[i] < cut);
+    return *this;
+}
+
+const ObjectMask& Preselection::mask() {
+    m_mask.pack(m_pass);
+    return m_mask;
+}
+
+}
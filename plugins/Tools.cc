@@ -6,80 +6,52 @@
 
 float HHAnalyzer::getCosThetaStar_CS(const LorentzVector & h1, const LorentzVector & h2, float ebeam /*= 6500*/) {
     // cos theta star angle in the Collins Soper frame
-    LorentzVector p1, p2;
-    p1.SetPxPyPzE(0, 0,  ebeam, ebeam);
-    p2.SetPxPyPzE(0, 0, -ebeam, ebeam);
-
-    LorentzVector hh = h1 + h2;
-    ROOT::Math::Boost boost(-hh.X() / hh.T(), -hh.Y() / hh.T(), -hh.Z() / hh.T());
-    p1 = boost(p1);
-    p2 = boost(p2);
-    LorentzVector newh1 = boost(h1);
-    ROOT::Math::DisplacementVector3D<ROOT::Math::Cartesian3D<float>> CSaxis(p1.Vect().Unit() - p2.Vect().Unit());
-
-    return cos(ROOT::Math::VectorUtil::Angle(CSaxis.Unit(), newh1.Vect().Unit()));
+    return HH::cosThetaStarCS(HH::CartesianP4(h1), HH::CartesianP4(h2), ebeam);
 }
 
-MELAAngles HHAnalyzer::getMELAAngles(const LorentzVector &q1, const LorentzVector &q2, const LorentzVector &q11, const LorentzVector &q12, const LorentzVector &q21, const LorentzVector &q22, float ebeam /*= 6500*/) {
-    MELAAngles angles;
-    LorentzVector p1, p2;
-    p1.SetPxPyPzE(0, 0,  ebeam, ebeam);
-    p2.SetPxPyPzE(0, 0, -ebeam, ebeam);
-
-    // set yourselves to the q1 + q2 rest frame, everyone! (note the prefix 'b' for 'boosted')
-    LorentzVector X = q1 + q2;
-    ROOT::Math::Boost boost(-X.X() / X.T(), -X.Y() / X.T(), -X.Z() / X.T());
-    LorentzVector b_p1 = boost(p1);
-    LorentzVector b_p2 = boost(p2);
-    LorentzVector b_q1 = boost(q1);
-    LorentzVector b_q11 = boost(q11);
-    LorentzVector b_q12 = boost(q12);
-    LorentzVector b_q21 = boost(q21);
-    LorentzVector b_q22 = boost(q22);
-    // Amend that, actually we also want some stuff in q1 or q2 rest frame
-    ROOT::Math::Boost boost1(-q1.X() / q1.T(), -q1.Y() / q1.T(), -q1.Z() / q1.T());
-    ROOT::Math::Boost boost2(-q2.X() / q2.T(), -q2.Y() / q2.T(), -q2.Z() / q2.T());
-    LorentzVector b1_q2 = boost1(q2);
-    LorentzVector b1_q11 = boost1(q11);
-    LorentzVector b2_q1 = boost2(q1);
-    LorentzVector b2_q21 = boost2(q21);
-    // let's concentrate on three-momenta (note the prefix 'm' for three-'momenta')
-    ROOT::Math::XYZVectorF m_q1(b_q1.Px(), b_q1.Py(), b_q1.Pz());
-    ROOT::Math::XYZVectorF m_q11(b_q11.Px(), b_q11.Py(), b_q11.Pz());
-    ROOT::Math::XYZVectorF m_q12(b_q12.Px(), b_q12.Py(), b_q12.Pz());
-    ROOT::Math::XYZVectorF m_q21(b_q21.Px(), b_q21.Py(), b_q21.Pz());
-    ROOT::Math::XYZVectorF m_q22(b_q22.Px(), b_q22.Py(), b_q22.Pz());
-    // let's get as well three-momenta in q1 and q2 rest frame where appropriate;
-    ROOT::Math::XYZVectorF m1_q2(b1_q2.Px(), b1_q2.Py(), b1_q2.Pz());
-    ROOT::Math::XYZVectorF m1_q11(b1_q11.Px(), b1_q11.Py(), b1_q11.Pz());
-    ROOT::Math::XYZVectorF m2_q1(b2_q1.Px(), b2_q1.Py(), b2_q1.Pz());
-    ROOT::Math::XYZVectorF m2_q21(b2_q21.Px(), b2_q21.Py(), b2_q21.Pz());
-
-    // Define reference vectors
-    ROOT::Math::XYZVectorF n1(m_q11.Cross(m_q12).Unit());
-    ROOT::Math::XYZVectorF n2(m_q21.Cross(m_q22).Unit());
-    ROOT::Math::XYZVectorF nz(0., 0., 1.);
-    ROOT::Math::XYZVectorF nsc(nz.Cross(m_q1).Unit());
-
-    // MELA angles as taken from https://arxiv.org/pdf/1208.4018v3.pdf
-    angles.phi = m_q1.Dot(n1.Cross(n2)) / fabs(m_q1.Dot(n1.Cross(n2))) * acos(- n1.Dot(n2));
-    float phi1 = m_q1.Dot(n1.Cross(nsc)) / fabs(m_q1.Dot(n1.Cross(nsc))) * acos(n1.Dot(nsc));
-    angles.psi = phi1 + angles.phi / 2.;
-    angles.theta1 = acos(- m1_q2.Dot(m1_q11) / sqrt(m1_q2.Dot(m1_q2)) / sqrt(m1_q11.Dot(m1_q11)));
-    angles.theta2 = acos(- m2_q1.Dot(m2_q21) / sqrt(m2_q1.Dot(m2_q1)) / sqrt(m2_q21.Dot(m2_q21)));
-    // thetaStar is defined in the Collins-Soper frame
-    ROOT::Math::DisplacementVector3D<ROOT::Math::Cartesian3D<float>> CSaxis(b_p1.Vect().Unit() - b_p2.Vect().Unit());
-    angles.thetaStar = ROOT::Math::VectorUtil::Angle(CSaxis.Unit(), b_q1.Vect().Unit());
-
-    return angles;
-}
+namespace {
 
-void HHAnalyzer::matchOfflineLepton(const HLTProducer& hlt, HH::Dilepton& dilepton) {
+    void clearHLTMatch(HH::Lepton& lepton) {
+        lepton.hlt_idx = -1;
+        lepton.hlt_already_tried_matching = true;
+        lepton.hlt_DR_matchedObject = std::numeric_limits<float>::max();
+        lepton.hlt_DPtOverPt_matchedObject = std::numeric_limits<float>::max();
+    }
 
-    if (leptons[dilepton.ilep1].hlt_already_tried_matching && leptons[dilepton.ilep2].hlt_already_tried_matching) {
-        if (HH_HLT_DEBUG) std::cout << "The HLT matching for this lepton pair has already been attempted, stopping here" << std::endl;
-        return;
+    // Whether one of the HLT objects passed one of the filters of the mask
+    bool isLegMatched(HH::HLTObjectFlags& flags, const std::vector<int8_t>& indices, uint64_t filters) {
+        return std::any_of(indices.begin(), indices.end(), [&](int8_t index) { return flags.passFilters(index, filters); });
+    }
+
+    // Same flavour: the legs are found from the filters of the channel
+    template <typename Channel>
+    void assignHLTLegs(const HH::SameFlavourDileptonChannel&, HH::HLTObjectFlags& flags, const std::array<uint64_t, triggerLeg::Count>& leg_filters,
+            const std::vector<int8_t>& l1_indices, const std::vector<int8_t>& l2_indices, HH::Lepton& lep1, HH::Lepton& lep2) {
+        if (HH_HLT_DEBUG) std::cout << "\tfinding dilepton legs: " << Channel::name() << std::endl;
+
+        lep1.hlt_leg1 = isLegMatched(flags, l1_indices, leg_filters[Channel::leg1]);
+        lep1.hlt_leg2 = isLegMatched(flags, l1_indices, leg_filters[Channel::leg2]);
+        lep2.hlt_leg1 = isLegMatched(flags, l2_indices, leg_filters[Channel::leg1]);
+        lep2.hlt_leg2 = isLegMatched(flags, l2_indices, leg_filters[Channel::leg2]);
+    }
+
+    // Different flavour: if the two offline objects are matching the same different flavour HLT path
+    // then the leg1 and leg2 assignment is in sync with the order of the path name itself
+    template <typename Channel>
+    void assignHLTLegs(const HH::DifferentFlavourDileptonChannel&, HH::HLTObjectFlags&, const std::array<uint64_t, triggerLeg::Count>&,
+            const std::vector<int8_t>&, const std::vector<int8_t>&, HH::Lepton& lep1, HH::Lepton& lep2) {
+        if (HH_HLT_DEBUG) std::cout << "\tfinding dilepton legs: different flavour" << std::endl;
+
+        // Leg 1 is alway mu, and leg 2 always electron
+        lep1.hlt_leg1 = std::is_same<typename Channel::Flavour1, HH::flavour::Mu>::value;
+        lep1.hlt_leg2 = !lep1.hlt_leg1;
+
+        lep2.hlt_leg1 = !lep1.hlt_leg1;
+        lep2.hlt_leg2 = !lep1.hlt_leg2;
     }
+}
+
+void HHAnalyzer::matchOfflineLepton(const HLTProducer& hlt, HH::Dilepton& dilepton) {
 
     if (HH_HLT_DEBUG) {
         std::cout << "Trying to match offline leptons " << dilepton.ilep1 << " and " << dilepton.ilep2 << " (there is " << hlt.object_p4.size() << " candidate HLT objects): " << std::endl;
@@ -96,49 +68,54 @@ void HHAnalyzer::matchOfflineLepton(const HLTProducer& hlt, HH::Dilepton& dilept
             << " ; E: " << leptons[dilepton.ilep2].p4.E() 
             << std::endl;
     }
-    std::vector<int8_t> l1_all_indices;
-    std::vector<int8_t> l2_all_indices;
-    // Preselection
-    for (size_t hlt_object = 0; hlt_object < hlt.object_p4.size(); hlt_object++) {
-        float l1_dr = ROOT::Math::VectorUtil::DeltaR(leptons[dilepton.ilep1].p4, hlt.object_p4[hlt_object]);
-        float l2_dr = ROOT::Math::VectorUtil::DeltaR(leptons[dilepton.ilep2].p4, hlt.object_p4[hlt_object]);
-        float l1_dpt_over_pt = fabs(leptons[dilepton.ilep1].p4.Pt() - hlt.object_p4[hlt_object].Pt()) / leptons[dilepton.ilep1].p4.Pt();
-        float l2_dpt_over_pt = fabs(leptons[dilepton.ilep2].p4.Pt() - hlt.object_p4[hlt_object].Pt()) / leptons[dilepton.ilep2].p4.Pt();
-        if (HH_HLT_DEBUG && false) { // quite verbose even for debugging
+    // The flavours decide the HLT objects and the leg assignment: one dispatch per pair
+    if (!HH::dispatchDileptonChannel(leptons[dilepton.ilep1], leptons[dilepton.ilep2], [&](auto channel) { matchOfflineLepton<decltype(channel)>(hlt, dilepton); })) {
+        clearHLTMatch(leptons[dilepton.ilep1]);
+        clearHLTMatch(leptons[dilepton.ilep2]);
+    }
+}
+
+template <typename Channel>
+void HHAnalyzer::matchOfflineLepton(const HLTProducer& hlt, HH::Dilepton& dilepton) {
+
+    // Preselection, on the HLT objects within m_hltDRCut of each lepton only (see hlt_matcher). It does not depend on
+    // the other lepton, and is done once per lepton
+    auto preselect = [this, &hlt](size_t ilep, auto flavour) -> const std::vector<int8_t>& {
+        std::vector<int8_t>& indices = hlt_lepton_objects[ilep];
+        if (hlt_lepton_objects_cached[ilep])
+            return indices;
+        hlt_lepton_objects_cached[ilep] = true;
+        indices.clear();
+
+        const HH::Lepton& lepton = leptons[ilep];
+        hlt_matcher.withinCone(lepton.p4.Eta(), lepton.p4.Phi(), m_hltDRCut, hlt_matches);
+        for (uint32_t hlt_object: hlt_matches) {
+            float dpt_over_pt = fabs(lepton.p4.Pt() - hlt.object_p4[hlt_object].Pt()) / lepton.p4.Pt();
+            if (HH_HLT_DEBUG && false) { // quite verbose even for debugging
                 int8_t index = hlt_object;
                 for (auto &path: hlt.object_paths[index])
                     std::cout << "\t# HLT path # " << +index << "\t" << path << std::endl;
                 if (false) // extra verbose for further debugging
                     for (auto &filter: hlt.object_filters[index])
                         std::cout << "\t# HLT filter # " << +index << "\t" << filter << std::endl;
-                std::cout << "\tPDG Id: " << hlt.object_pdg_id[index] 
-                    << " ; Pt: " << hlt.object_p4[index].Pt() 
-                    << " ; Eta: " << hlt.object_p4[index].Eta() 
-                    << " ; Phi: " << hlt.object_p4[index].Phi() 
-                    << " ; E: " << hlt.object_p4[index].E() 
+                std::cout << "\tPDG Id: " << hlt.object_pdg_id[index]
+                    << " ; Pt: " << hlt.object_p4[index].Pt()
+                    << " ; Eta: " << hlt.object_p4[index].Eta()
+                    << " ; Phi: " << hlt.object_p4[index].Phi()
+                    << " ; E: " << hlt.object_p4[index].E()
                     << std::endl;
-                std::cout << "\tΔR: " << l1_dr
-                    << " ; ΔPt / Pt: " << l1_dpt_over_pt
+                std::cout << "\tΔR: " << ROOT::Math::VectorUtil::DeltaR(lepton.p4, hlt.object_p4[index])
+                    << " ; ΔPt / Pt: " << dpt_over_pt
                     << std::endl;
-                std::cout << "\tΔR: " << l2_dr
-                    << " ; ΔPt / Pt: " << l2_dpt_over_pt
-                    << std::endl;
-        }
-        if (l1_dr < m_hltDRCut
-            && l1_dpt_over_pt < m_hltDPtCut
-            && ((fabs(hlt.object_pdg_id[hlt_object]) == 13 && leptons[dilepton.ilep1].isMu)
-                || (fabs(hlt.object_pdg_id[hlt_object]) == 0 && leptons[dilepton.ilep1].isEl)) // It is unfortunate but the PDG ID is not correct in HLT objects
-            ) {
-            l1_all_indices.push_back(hlt_object);
-        }
-        if (l2_dr < m_hltDRCut
-            && l2_dpt_over_pt < m_hltDPtCut
-            && ((fabs(hlt.object_pdg_id[hlt_object]) == 13 && leptons[dilepton.ilep2].isMu)
-                || (fabs(hlt.object_pdg_id[hlt_object]) == 0 && leptons[dilepton.ilep2].isEl)) // It is unfortunate but the PDG ID is not correct in HLT objects
-            ) {
-            l2_all_indices.push_back(hlt_object);
+            }
+            if (dpt_over_pt < m_hltDPtCut && decltype(flavour)::isHLTObject(hlt.object_pdg_id[hlt_object])) {
+                indices.push_back(hlt_object);
+            }
         }
-    }
+        return indices;
+    };
+    const std::vector<int8_t>& l1_all_indices = preselect(dilepton.ilep1, typename Channel::Flavour1());
+    const std::vector<int8_t>& l2_all_indices = preselect(dilepton.ilep2, typename Channel::Flavour2());
     if (l1_all_indices.empty()) {
         leptons[dilepton.ilep1].hlt_idx = -1;
         leptons[dilepton.ilep1].hlt_already_tried_matching = true;
@@ -153,34 +130,23 @@ void HHAnalyzer::matchOfflineLepton(const HLTProducer& hlt, HH::Dilepton& dilept
     }
     // Check that the hlt path name is the same for both legs
     // FIXME: beware the day of adding single lepton HLT paths....
-    std::vector<int8_t> l1_samepath_indices;
-    std::vector<int8_t> l2_samepath_indices;
+    std::vector<int8_t>& l1_samepath_indices = hlt_samepath_indices.first;
+    std::vector<int8_t>& l2_samepath_indices = hlt_samepath_indices.second;
+    l1_samepath_indices.clear();
+    l2_samepath_indices.clear();
     for (auto& i1: l1_all_indices) {
         for (auto& i2: l2_all_indices) {
-            if (i1 == i2)
-                continue;
-            for (auto& path1: hlt.object_paths[i1]) {
-                for (auto& path2: hlt.object_paths[i2]) {
-                    if (path1 == path2)
-                    {
-                        l1_samepath_indices.push_back(i1);
-                        l2_samepath_indices.push_back(i2);
-                    }
-                }
+            if (i1 != i2 && hlt_flags.sharePath(i1, i2)) {
+                l1_samepath_indices.push_back(i1);
+                l2_samepath_indices.push_back(i2);
             }
         }
     }
     if (l1_samepath_indices.empty()) {
         if (HH_HLT_DEBUG)
             std::cout << "\033[31mNo common HLT name match for the two leptons\033[00m" << std::endl;
-        leptons[dilepton.ilep1].hlt_idx = -1;
-        leptons[dilepton.ilep1].hlt_already_tried_matching = true;
-        leptons[dilepton.ilep1].hlt_DR_matchedObject = std::numeric_limits<float>::max();
-        leptons[dilepton.ilep1].hlt_DPtOverPt_matchedObject = std::numeric_limits<float>::max();
-        leptons[dilepton.ilep2].hlt_idx = -1;
-        leptons[dilepton.ilep2].hlt_already_tried_matching = true;
-        leptons[dilepton.ilep2].hlt_DR_matchedObject = std::numeric_limits<float>::max();
-        leptons[dilepton.ilep2].hlt_DPtOverPt_matchedObject = std::numeric_limits<float>::max();
+        clearHLTMatch(leptons[dilepton.ilep1]);
+        clearHLTMatch(leptons[dilepton.ilep2]);
         return;
     }
     // We have two hlt objects firing the same path: each lepton should be at least leg2, let's make sure of that
@@ -189,63 +155,7 @@ void HHAnalyzer::matchOfflineLepton(const HLTProducer& hlt, HH::Dilepton& dilept
     leptons[dilepton.ilep2].hlt_leg1 = false;
     leptons[dilepton.ilep2].hlt_leg2 = false;
     // Check who is leg1 who is leg2
-    if (
-           // Di-muon
-           (leptons[dilepton.ilep1].isMu && leptons[dilepton.ilep2].isMu) ||
-           // Di-eletron
-           (leptons[dilepton.ilep1].isEl && leptons[dilepton.ilep2].isEl)
-       ) {
-
-        std::vector<std::string> filter_leg1;
-        std::vector<std::string> filter_leg2;
-
-        static auto isLegMatched = [&hlt](const std::vector<int8_t> path_indices, const std::vector<std::string>& filters) -> bool {
-            return
-                std::any_of(path_indices.begin(), path_indices.end(), [&](int8_t index) {
-                    for (const auto& filter: filters) {
-                        if (std::any_of(hlt.object_filters[index].begin(), hlt.object_filters[index].end(), [&filter](const std::string& f) { return f == filter; }))
-                            return true;
-                    }
-
-                    return false;
-                });
-        };
-
-        if (leptons[dilepton.ilep1].isMu && leptons[dilepton.ilep2].isMu) {
-            // di-muon filters: from the path name the legs can have asymetric cuts, taken filters from 
-            // https://github.com/cms-analysis/MuonAnalysis-TagAndProbe/blob/fa1f8f3d469a5a78754ed4b4c43adbfad39a2544/python/common_variables_cff.py#L253-L264
-            if (HH_HLT_DEBUG) std::cout << "\tfinding dilepton legs: di-muon" << std::endl;
-            filter_leg1.push_back("hltL3fL1sDoubleMu114L1f0L2f10OneMuL3Filtered17");
-            filter_leg1.push_back("hltL3fL1sDoubleMu114L1f0L2f10L3Filtered17");
-            filter_leg2.push_back("hltL3pfL1sDoubleMu114L1f0L2pf0L3PreFiltered8");
-            filter_leg2.push_back("hltDiMuonGlbFiltered17TrkFiltered8");
-            filter_leg2.push_back("hltL2pfL1sDoubleMu114ORDoubleMu125L1f0L2PreFiltered0");
-        } else {
-            if (HH_HLT_DEBUG) std::cout << "\tfinding dilepton legs: di-electron" << std::endl;
-            filter_leg1.push_back("hltEle17Ele12CaloIdLTrackIdLIsoVLTrackIsoLeg1Filter");
-            filter_leg1.push_back("hltEle23Ele12CaloIdLTrackIdLIsoVLTrackIsoLeg1Filter");
-            filter_leg2.push_back("hltEle17Ele12CaloIdLTrackIdLIsoVLTrackIsoLeg2Filter");
-            filter_leg2.push_back("hltEle23Ele12CaloIdLTrackIdLIsoVLTrackIsoLeg2Filter");
-        }
-
-        leptons[dilepton.ilep1].hlt_leg1 = isLegMatched(l1_samepath_indices, filter_leg1);
-        leptons[dilepton.ilep1].hlt_leg2 = isLegMatched(l1_samepath_indices, filter_leg2);
-        leptons[dilepton.ilep2].hlt_leg1 = isLegMatched(l2_samepath_indices, filter_leg1);
-        leptons[dilepton.ilep2].hlt_leg2 = isLegMatched(l2_samepath_indices, filter_leg2);
-
-    } else if ((leptons[dilepton.ilep1].isEl && leptons[dilepton.ilep2].isMu)
-        || (leptons[dilepton.ilep1].isMu && leptons[dilepton.ilep2].isEl)) {
-        // if the two offline objects are matching the same different flavour HLT path
-        // then the leg1 and leg2 assignment is in sync with the order of the path name itself
-        if (HH_HLT_DEBUG) std::cout << "\tfinding dilepton legs: different flavour" << std::endl;
-
-        // Leg 1 is alway mu, and leg 2 always electron
-        leptons[dilepton.ilep1].hlt_leg1 = leptons[dilepton.ilep1].isMu;
-        leptons[dilepton.ilep1].hlt_leg2 = leptons[dilepton.ilep1].isEl;
-
-        leptons[dilepton.ilep2].hlt_leg1 = !leptons[dilepton.ilep1].hlt_leg1;
-        leptons[dilepton.ilep2].hlt_leg2 = !leptons[dilepton.ilep1].hlt_leg2;
-    }
+    assignHLTLegs<Channel>(Channel(), hlt_flags, m_hlt_leg_filters, l1_samepath_indices, l2_samepath_indices, leptons[dilepton.ilep1], leptons[dilepton.ilep2]);
 
     if (HH_HLT_DEBUG) {
         std::cout << "\tLeg matching (before solving ambiguities):" << std::endl;
@@ -341,229 +251,180 @@ void HHAnalyzer::matchOfflineLepton(const HLTProducer& hlt, HH::Dilepton& dilept
 
 float HHAnalyzer::getL1TPhi(int charge, const LorentzVector& p) {
     float pt = p.Pt();
-    float theta = 180 / M_PI * p.Theta();
+    // theta = atan2(pt, pz) = atan2(1, sinh(eta))
+    float theta = 180 / M_PI * evaluateKinematics("theta", [&p]() -> float { return p.Theta(); }, [&p]() { return HH::fastmath::atan2(1.f, HH::fastmath::sinh(p.Eta())); });
     theta = ( theta <= 90 ) ? theta : 180 - theta;
     return p.Phi() + M_PI / 180 * charge * (1. / pt) * (10.48 - 5.1412 * theta + 0.02308 * theta * theta);
 }
 
-bool HHAnalyzer::sameEndCap(const LorentzVector& p1, const LorentzVector& p2) {
-    return p1.Eta() * p2.Eta() > 0 && std::abs(p1.Eta()) > 1.24 && std::abs(p2.Eta()) > 1.24;
+int8_t HHAnalyzer::getCSCEndCap(const LorentzVector& p) {
+    float eta = p.Eta();
+    if (!(std::abs(eta) > 1.24))
+        return 0;
+    return (eta > 0) ? 1 : -1;
 }
 
 float HHAnalyzer::translatePhi(float phi, float translation/*=0*/) {
     phi += translation; // translate
-    phi = std::fmod(phi, 2 * M_PI); // put between -2pi, 2pi
-    phi = (phi > 0) ? phi : (2 * M_PI + phi); // put between 0, 2pi
-    return phi;
+    return evaluateKinematics("wrapPhi",
+            [phi]() -> float {
+                float wrapped = std::fmod(phi, 2 * M_PI); // put between -2pi, 2pi
+                return (wrapped > 0) ? wrapped : (2 * M_PI + wrapped); // put between 0, 2pi
+            },
+            [phi]() { return HH::fastmath::wrapPhiPositive(phi); });
 }
 
 int HHAnalyzer::getPhiSector(float phi, float start, float end) {
-    for (int i = 0; i < 6; i++) {
-        if (start + i * M_PI / 3 <= phi && phi < end + i * M_PI / 3)
-            return i;
-    }
-    return -1;
+    // The sectors do not overlap, so the only candidate is the last N with start + 60° * N <= phi. The division can
+    // be off by one at the boundaries, the comparisons are then done exactly as for the definition
+    double n = std::floor((phi - start) / (M_PI / 3));
+    int i = !(n >= 0) ? -1 : (n > 5) ? 5 : int(n);
+    if (i < 5 && start + (i + 1) * M_PI / 3 <= phi)
+        i++;
+    if (i >= 0 && phi < start + i * M_PI / 3)
+        i--;
+    return (i >= 0 && phi < end + i * M_PI / 3) ? i : -1;
+}
+
+void HHAnalyzer::fillL1TGeometry(Lepton& mu) {
+    mu.l1t_phi = translatePhi(getL1TPhi(mu.charge, mu.p4));
+    mu.csc_endcap = getCSCEndCap(mu.p4);
+    mu.csc_sector = getPhiSector(mu.l1t_phi, 15*M_PI/180, 65*M_PI/180);
+    mu.csc_overlap = getPhiSector(mu.l1t_phi, 5*M_PI/180, 15*M_PI/180);
 }
 
 bool HHAnalyzer::isCSCSameSector(const Lepton& lep1, const Lepton& lep2) {
-    if (!sameEndCap(lep1.p4, lep2.p4))
+    if (lep1.csc_endcap == 0 || lep1.csc_endcap != lep2.csc_endcap)
         return false;
 
-    float phi1 = translatePhi(getL1TPhi(lep1.charge, lep1.p4));
-    float phi2 = translatePhi(getL1TPhi(lep2.charge, lep2.p4));
-
-    int sector1 = getPhiSector(phi1, 15*M_PI/180, 65*M_PI/180);
-    int sector2 = getPhiSector(phi2, 15*M_PI/180, 65*M_PI/180);
-
-    int overlap1 = getPhiSector(phi1, 5*M_PI/180, 15*M_PI/180);
-    int overlap2 = getPhiSector(phi2, 5*M_PI/180, 15*M_PI/180);
-
-    if (sector1 >= 0 && sector2 >= 0 && sector1 == sector2)
+    if (lep1.csc_sector >= 0 && lep1.csc_sector == lep2.csc_sector)
         return true;
 
-    if (overlap1 >= 0 && overlap2 >= 0 && overlap1 == overlap2)
+    if (lep1.csc_overlap >= 0 && lep1.csc_overlap == lep2.csc_overlap)
         return true;
 
     return false;
 }
 
 bool HHAnalyzer::isCSCWithOverlap(const Lepton& lep1, const Lepton& lep2) {
-    if (!sameEndCap(lep1.p4, lep2.p4))
+    if (lep1.csc_endcap == 0 || lep1.csc_endcap != lep2.csc_endcap)
         return false;
 
-    float phi1 = translatePhi(getL1TPhi(lep1.charge, lep1.p4));
-    float phi2 = translatePhi(getL1TPhi(lep2.charge, lep2.p4));
-
-    int sector1 = getPhiSector(phi1, 15*M_PI/180, 65*M_PI/180);
-    int sector2 = getPhiSector(phi2, 15*M_PI/180, 65*M_PI/180);
-
-    int overlap1 = getPhiSector(phi1, 5*M_PI/180, 15*M_PI/180);
-    int overlap2 = getPhiSector(phi2, 5*M_PI/180, 15*M_PI/180);
-
-    if (sector1 >= 0 && overlap2 >= 0 && (sector1 == overlap2 || sector1 + 1 == overlap2))
+    if (lep1.csc_sector >= 0 && lep2.csc_overlap >= 0 && (lep1.csc_sector == lep2.csc_overlap || lep1.csc_sector + 1 == lep2.csc_overlap))
         return true;
 
-    if (sector2 >= 0 && overlap1 >= 0 && (sector2 == overlap1 || sector2 + 1 == overlap1))
+    if (lep2.csc_sector >= 0 && lep1.csc_overlap >= 0 && (lep2.csc_sector == lep1.csc_overlap || lep2.csc_sector + 1 == lep1.csc_overlap))
         return true;
 
     return false;
 }
 
-void HHAnalyzer::fillTriggerEfficiencies(const Lepton & lep1, const Lepton & lep2, Dilepton & dilep) {
+HH::EfficiencyValue HHAnalyzer::getTriggerLegEfficiency(triggerLeg::triggerLeg leg, float eta, float pt) {
+    if (m_hlt_compiled_legs[leg])
+        return m_hlt_compiled_legs[leg]->get(eta, pt);
 
-    float eff_lep1_leg1 = 1.;
-    float eff_lep1_leg2 = 1.;
-    float eff_lep2_leg1 = 1.;
-    float eff_lep2_leg2 = 1.;
+    const BinnedValues* values = m_hlt_legs[leg];
+    if (!values)
+        throw std::out_of_range("Missing HLT efficiency: " + triggerLeg::map.at(leg));
 
-    // See https://cp3-llbb.slack.com/archives/hh/p1486479524001043
-    // See https://cp3-llbb.slack.com/archives/hh/p1486482180001053
-    constexpr float DZ_filter_eff_MuMu = 0.993;
-    constexpr float DZ_filter_eff_ElEl = 0.983;
-    constexpr float DZ_filter_eff_MuEl = 0.988;
-    constexpr float DZ_filter_eff_ElMu = 0.982;
-
-    // See https://cp3-llbb.slack.com/archives/hh/p1486566100001301
-    constexpr float L1_EMTF_bug_eff_MuMu = 0.5265;
+    // One bin search for the efficiency and both errors
+    hlt_parameters.setEta(eta).setPt(pt);
+    const std::vector<float> eff = values->get(hlt_parameters);
+    return {eff[0], eff[1], eff[2]};
+}
 
-    float DZ_filter_eff = 1.;
+template <typename Channel, typename Flavour>
+void HHAnalyzer::fillTriggerLegEfficiencies(Lepton & lep) {
 
-    Parameters p_hlt_lep1 = {{BinningVariable::Eta, lep1.p4.Eta()}, {BinningVariable::Pt, lep1.p4.Pt()}};
-    Parameters p_hlt_lep2 = {{BinningVariable::Eta, lep2.p4.Eta()}, {BinningVariable::Pt, lep2.p4.Pt()}};
+    if (lep.hlt_efficiencies_cached & Channel::cached)
+        return;
 
     // Replace eta by supercluster eta for electrons
-    if (lep1.isEl)
-        p_hlt_lep1.setEta(lep1.sc_eta);
-
-    if (lep2.isEl)
-        p_hlt_lep2.setEta(lep2.sc_eta);
-
-    if (lep1.isMu && lep2.isMu) {
-        eff_lep1_leg1 = m_hlt_efficiencies.at("IsoMu17leg")->get(p_hlt_lep1)[0];
-        eff_lep1_leg2 = m_hlt_efficiencies.at("IsoMu8orIsoTkMu8leg")->get(p_hlt_lep1)[0];
-        eff_lep2_leg1 = m_hlt_efficiencies.at("IsoMu17leg")->get(p_hlt_lep2)[0];
-        eff_lep2_leg2 = m_hlt_efficiencies.at("IsoMu8orIsoTkMu8leg")->get(p_hlt_lep2)[0];
-        DZ_filter_eff = DZ_filter_eff_MuMu;
-        // FIXME L1 EMTF bug
-        if (isCSCSameSector(lep1, lep2))
-            DZ_filter_eff *= L1_EMTF_bug_eff_MuMu;
-    }
-    else if (lep1.isMu && lep2.isEl) {
-        eff_lep1_leg1 = m_hlt_efficiencies.at("IsoMu23leg")->get(p_hlt_lep1)[0];
-        eff_lep1_leg2 = m_hlt_efficiencies.at("IsoMu8leg")->get(p_hlt_lep1)[0];
-        eff_lep2_leg1 = m_hlt_efficiencies.at("EleMuHighPtleg")->get(p_hlt_lep2)[0];
-        eff_lep2_leg2 = m_hlt_efficiencies.at("MuEleLowPtleg")->get(p_hlt_lep2)[0];
-        DZ_filter_eff = DZ_filter_eff_MuEl;
-    }
-    else if (lep1.isEl && lep2.isMu) {
-        eff_lep1_leg1 = m_hlt_efficiencies.at("EleMuHighPtleg")->get(p_hlt_lep1)[0];
-        eff_lep1_leg2 = m_hlt_efficiencies.at("MuEleLowPtleg")->get(p_hlt_lep1)[0];
-        eff_lep2_leg1 = m_hlt_efficiencies.at("IsoMu23leg")->get(p_hlt_lep2)[0];
-        eff_lep2_leg2 = m_hlt_efficiencies.at("IsoMu8leg")->get(p_hlt_lep2)[0];
-        DZ_filter_eff = DZ_filter_eff_ElMu;
-    }
-    else if (lep1.isEl && lep2.isEl){
-        eff_lep1_leg1 = m_hlt_efficiencies.at("DoubleEleHighPtleg")->get(p_hlt_lep1)[0];
-        eff_lep1_leg2 = m_hlt_efficiencies.at("DoubleEleLowPtleg")->get(p_hlt_lep1)[0];
-        eff_lep2_leg1 = m_hlt_efficiencies.at("DoubleEleHighPtleg")->get(p_hlt_lep2)[0];
-        eff_lep2_leg2 = m_hlt_efficiencies.at("DoubleEleLowPtleg")->get(p_hlt_lep2)[0];
-        DZ_filter_eff = DZ_filter_eff_ElEl;
-    }
-    else 
-        std::cout << "We have something else then el or mu !!" << std::endl;
+    const float eta = lep.isEl ? lep.sc_eta : lep.p4.Eta();
+    const float pt = lep.p4.Pt();
 
-    float error_eff_lep1_leg1_up = 0.;
-    float error_eff_lep1_leg2_up = 0.;
-    float error_eff_lep2_leg1_up = 0.;
-    float error_eff_lep2_leg2_up = 0.;
+    Channel::leg1Efficiency(lep) = getTriggerLegEfficiency(Channel::template leg1Of<Flavour>(), eta, pt);
+    Channel::leg2Efficiency(lep) = getTriggerLegEfficiency(Channel::template leg2Of<Flavour>(), eta, pt);
 
-    if (lep1.isMu && lep2.isMu) {
-        error_eff_lep1_leg1_up = m_hlt_efficiencies.at("IsoMu17leg")->get(p_hlt_lep1)[2];
-        error_eff_lep1_leg2_up = m_hlt_efficiencies.at("IsoMu8orIsoTkMu8leg")->get(p_hlt_lep1)[2];
-        error_eff_lep2_leg1_up = m_hlt_efficiencies.at("IsoMu17leg")->get(p_hlt_lep2)[2];
-        error_eff_lep2_leg2_up = m_hlt_efficiencies.at("IsoMu8orIsoTkMu8leg")->get(p_hlt_lep2)[2];
-    }
-    else if (lep1.isMu && lep2.isEl) {
-        error_eff_lep1_leg1_up = m_hlt_efficiencies.at("IsoMu23leg")->get(p_hlt_lep1)[2];
-        error_eff_lep1_leg2_up = m_hlt_efficiencies.at("IsoMu8leg")->get(p_hlt_lep1)[2];
-        error_eff_lep2_leg1_up = m_hlt_efficiencies.at("EleMuHighPtleg")->get(p_hlt_lep2)[2];
-        error_eff_lep2_leg2_up = m_hlt_efficiencies.at("MuEleLowPtleg")->get(p_hlt_lep2)[2];
-    }
-    else if (lep1.isEl && lep2.isMu) {
-        error_eff_lep1_leg1_up = m_hlt_efficiencies.at("EleMuHighPtleg")->get(p_hlt_lep1)[2];
-        error_eff_lep1_leg2_up = m_hlt_efficiencies.at("MuEleLowPtleg")->get(p_hlt_lep1)[2];
-        error_eff_lep2_leg1_up = m_hlt_efficiencies.at("IsoMu23leg")->get(p_hlt_lep2)[2];
-        error_eff_lep2_leg2_up = m_hlt_efficiencies.at("IsoMu8leg")->get(p_hlt_lep2)[2];
-    }
-    else if (lep1.isEl && lep2.isEl){
-        error_eff_lep1_leg1_up = m_hlt_efficiencies.at("DoubleEleHighPtleg")->get(p_hlt_lep1)[2];
-        error_eff_lep1_leg2_up = m_hlt_efficiencies.at("DoubleEleLowPtleg")->get(p_hlt_lep1)[2];
-        error_eff_lep2_leg1_up = m_hlt_efficiencies.at("DoubleEleHighPtleg")->get(p_hlt_lep2)[2];
-        error_eff_lep2_leg2_up = m_hlt_efficiencies.at("DoubleEleLowPtleg")->get(p_hlt_lep2)[2];
+    lep.hlt_efficiencies_cached |= Channel::cached;
+}
+
+namespace {
+
+    // Efficiency of a dilepton trigger with two legs, and its errors
+    void combineTriggerLegEfficiencies(const HH::EfficiencyValue& lep1_leg1, const HH::EfficiencyValue& lep1_leg2,
+            const HH::EfficiencyValue& lep2_leg1, const HH::EfficiencyValue& lep2_leg2, float DZ_filter_eff, HH::Dilepton& dilep) {
+
+        float eff_lep1_leg1 = lep1_leg1.value;
+        float eff_lep1_leg2 = lep1_leg2.value;
+        float eff_lep2_leg1 = lep2_leg1.value;
+        float eff_lep2_leg2 = lep2_leg2.value;
+
+        float error_eff_lep1_leg1_up = lep1_leg1.error_high;
+        float error_eff_lep1_leg2_up = lep1_leg2.error_high;
+        float error_eff_lep2_leg1_up = lep2_leg1.error_high;
+        float error_eff_lep2_leg2_up = lep2_leg2.error_high;
+
+        float error_eff_lep1_leg1_down = lep1_leg1.error_low;
+        float error_eff_lep1_leg2_down = lep1_leg2.error_low;
+        float error_eff_lep2_leg1_down = lep2_leg1.error_low;
+        float error_eff_lep2_leg2_down = lep2_leg2.error_low;
+
+        float nominal = -(eff_lep1_leg1 * eff_lep2_leg1) +
+            (1 - (1 - eff_lep1_leg2)) * eff_lep2_leg1 +
+            eff_lep1_leg1 * (1 - (1 - eff_lep2_leg2));
+
+        float error_squared_up =
+            std::pow(1 - eff_lep2_leg1 - (1 - eff_lep2_leg2), 2) *
+            std::pow(error_eff_lep1_leg1_up, 2) +
+            std::pow(eff_lep2_leg1, 2) *
+            std::pow(error_eff_lep1_leg2_up, 2) +
+            std::pow(1 - eff_lep1_leg1 - (1 - eff_lep1_leg2), 2) *
+            std::pow(error_eff_lep2_leg1_up, 2) +
+            std::pow(eff_lep1_leg1, 2) *
+            std::pow(error_eff_lep2_leg2_up, 2);
+
+        float error_squared_down = 
+            std::pow(1 - eff_lep2_leg1 - (1 - eff_lep2_leg2), 2) *
+            std::pow(error_eff_lep1_leg1_down, 2) +
+            std::pow(eff_lep2_leg1, 2) *
+            std::pow(error_eff_lep1_leg2_down, 2) +
+            std::pow(1 - eff_lep1_leg1 - (1 - eff_lep1_leg2), 2) *
+            std::pow(error_eff_lep2_leg1_down, 2) +
+            std::pow(eff_lep1_leg1, 2) *
+            std::pow(error_eff_lep2_leg2_down, 2);
+
+        nominal *= DZ_filter_eff;
+        error_squared_up *= DZ_filter_eff * DZ_filter_eff;
+        error_squared_down *= DZ_filter_eff * DZ_filter_eff;
+
+        dilep.trigger_efficiency = nominal;
+        dilep.trigger_efficiency_upVariated = ((nominal + std::sqrt(error_squared_up)) > 1.) ? 1. : (nominal + std::sqrt(error_squared_up));
+        dilep.trigger_efficiency_downVariated = ((nominal - std::sqrt(error_squared_down)) < 0.) ? 0. : (nominal - std::sqrt(error_squared_down));
     }
+}
 
-    float error_eff_lep1_leg1_down = 0.;
-    float error_eff_lep1_leg2_down = 0.;
-    float error_eff_lep2_leg1_down = 0.;
-    float error_eff_lep2_leg2_down = 0.;
+void HHAnalyzer::fillTriggerEfficiencies(Lepton & lep1, Lepton & lep2, Dilepton & dilep) {
 
-    if (lep1.isMu && lep2.isMu) {
-        error_eff_lep1_leg1_down = m_hlt_efficiencies.at("IsoMu17leg")->get(p_hlt_lep1)[1];
-        error_eff_lep1_leg2_down = m_hlt_efficiencies.at("IsoMu8orIsoTkMu8leg")->get(p_hlt_lep1)[1];
-        error_eff_lep2_leg1_down = m_hlt_efficiencies.at("IsoMu17leg")->get(p_hlt_lep2)[1];
-        error_eff_lep2_leg2_down = m_hlt_efficiencies.at("IsoMu8orIsoTkMu8leg")->get(p_hlt_lep2)[1];
-    }
-    else if (lep1.isMu && lep2.isEl) {
-        error_eff_lep1_leg1_down = m_hlt_efficiencies.at("IsoMu23leg")->get(p_hlt_lep1)[1];
-        error_eff_lep1_leg2_down = m_hlt_efficiencies.at("IsoMu8leg")->get(p_hlt_lep1)[1];
-        error_eff_lep2_leg1_down = m_hlt_efficiencies.at("EleMuHighPtleg")->get(p_hlt_lep2)[1];
-        error_eff_lep2_leg2_down = m_hlt_efficiencies.at("MuEleLowPtleg")->get(p_hlt_lep2)[1];
-    }
-    else if (lep1.isEl && lep2.isMu) {
-        error_eff_lep1_leg1_down = m_hlt_efficiencies.at("EleMuHighPtleg")->get(p_hlt_lep1)[1];
-        error_eff_lep1_leg2_down = m_hlt_efficiencies.at("MuEleLowPtleg")->get(p_hlt_lep1)[1];
-        error_eff_lep2_leg1_down = m_hlt_efficiencies.at("IsoMu23leg")->get(p_hlt_lep2)[1];
-        error_eff_lep2_leg2_down = m_hlt_efficiencies.at("IsoMu8leg")->get(p_hlt_lep2)[1];
-    }
-    else if (lep1.isEl && lep2.isEl){
-        error_eff_lep1_leg1_down = m_hlt_efficiencies.at("DoubleEleHighPtleg")->get(p_hlt_lep1)[1];
-        error_eff_lep1_leg2_down = m_hlt_efficiencies.at("DoubleEleLowPtleg")->get(p_hlt_lep1)[1];
-        error_eff_lep2_leg1_down = m_hlt_efficiencies.at("DoubleEleHighPtleg")->get(p_hlt_lep2)[1];
-        error_eff_lep2_leg2_down = m_hlt_efficiencies.at("DoubleEleLowPtleg")->get(p_hlt_lep2)[1];
+    if (!HH::dispatchDileptonChannel(lep1, lep2, [&](auto channel) { fillTriggerEfficiencies<decltype(channel)>(lep1, lep2, dilep); })) {
+        std::cout << "We have something else then el or mu !!" << std::endl;
+        combineTriggerLegEfficiencies({}, {}, {}, {}, 1., dilep);
     }
+}
+
+template <typename Channel>
+void HHAnalyzer::fillTriggerEfficiencies(Lepton & lep1, Lepton & lep2, Dilepton & dilep) {
+
+    // Only the legs of the channel are needed
+    fillTriggerLegEfficiencies<Channel, typename Channel::Flavour1>(lep1);
+    fillTriggerLegEfficiencies<Channel, typename Channel::Flavour2>(lep2);
 
+    float DZ_filter_eff = Channel::dzFilterEfficiency();
+    if (Channel::hasL1EMTFBug && isCSCSameSector(lep1, lep2))
+        DZ_filter_eff *= Channel::l1EMTFBugEfficiency();
 
-    float nominal = -(eff_lep1_leg1 * eff_lep2_leg1) +
-        (1 - (1 - eff_lep1_leg2)) * eff_lep2_leg1 +
-        eff_lep1_leg1 * (1 - (1 - eff_lep2_leg2));
-
-    float error_squared_up =
-        std::pow(1 - eff_lep2_leg1 - (1 - eff_lep2_leg2), 2) *
-        std::pow(error_eff_lep1_leg1_up, 2) +
-        std::pow(eff_lep2_leg1, 2) *
-        std::pow(error_eff_lep1_leg2_up, 2) +
-        std::pow(1 - eff_lep1_leg1 - (1 - eff_lep1_leg2), 2) *
-        std::pow(error_eff_lep2_leg1_up, 2) +
-        std::pow(eff_lep1_leg1, 2) *
-        std::pow(error_eff_lep2_leg2_up, 2);
-
-    float error_squared_down = 
-        std::pow(1 - eff_lep2_leg1 - (1 - eff_lep2_leg2), 2) *
-        std::pow(error_eff_lep1_leg1_down, 2) +
-        std::pow(eff_lep2_leg1, 2) *
-        std::pow(error_eff_lep1_leg2_down, 2) +
-        std::pow(1 - eff_lep1_leg1 - (1 - eff_lep1_leg2), 2) *
-        std::pow(error_eff_lep2_leg1_down, 2) +
-        std::pow(eff_lep1_leg1, 2) *
-        std::pow(error_eff_lep2_leg2_down, 2);
-
-    nominal *= DZ_filter_eff;
-    error_squared_up *= DZ_filter_eff * DZ_filter_eff;
-    error_squared_down *= DZ_filter_eff * DZ_filter_eff;
-
-    dilep.trigger_efficiency = nominal;
-    dilep.trigger_efficiency_upVariated = ((nominal + std::sqrt(error_squared_up)) > 1.) ? 1. : (nominal + std::sqrt(error_squared_up));
-    dilep.trigger_efficiency_downVariated = ((nominal - std::sqrt(error_squared_down)) < 0.) ? 0. : (nominal - std::sqrt(error_squared_down));
+    combineTriggerLegEfficiencies(Channel::leg1Efficiency(lep1), Channel::leg2Efficiency(lep1),
+            Channel::leg1Efficiency(lep2), Channel::leg2Efficiency(lep2), DZ_filter_eff, dilep);
 }
 
 
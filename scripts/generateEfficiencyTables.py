@@ -0,0 +1,139 @@
+#! /usr/bin/env python
+
+"""
+Generate interface/EfficiencyTables.h, the compiled version of the binned efficiencies of data/Efficiencies,
+used instead of parsing the JSON files (unless useCompiledEfficiencyTables is disabled).
+
+Run it from the root of the package after any change to the JSON files:
+    ./scripts/generateEfficiencyTables.py
+"""
+
+from __future__ import print_function
+
+import argparse
+import glob
+import json
+import os
+import struct
+
+PACKAGE = 'cp3_llbb/HHAnalysis'
+
+VARIABLES = {'Eta': 'BinningVariable::Eta', 'AbsEta': 'BinningVariable::AbsEta', 'Pt': 'BinningVariable::Pt'}
+
+
+def to_float(x):
+    """Round to single precision, as the values are stored"""
+    return struct.unpack('f', struct.pack('f', x))[0]
+
+
+def float_literal(x):
+    literal = '%.9g' % to_float(x)
+    if '.' not in literal and 'e' not in literal:
+        literal += '.'
+    return literal + 'f'
+
+
+def content_hash(path):
+    """64-bit FNV-1a hash of the file, same as HH::contentHash"""
+    h = 0xcbf29ce484222325
+    with open(path, 'rb') as f:
+        for byte in bytearray(f.read()):
+            h = ((h ^ byte) * 0x100000001b3) & 0xffffffffffffffff
+    return h
+
+
+def identifier(path):
+    return os.path.splitext(os.path.basename(path))[0].replace('-', '_')
+
+
+def axis(name, variable, edges):
+    return '{%s, %s, %d}' % (VARIABLES[variable], name, len(edges) - 1)
+
+
+def generate_table(path):
+    with open(path) as f:
+        content = json.load(f)
+
+    if content['dimension'] != 2 or len(content['variables']) != 2:
+        raise ValueError('%s: only two-dimensional tables are supported' % path)
+    if content.get('error_type', 'absolute') != 'absolute':
+        raise ValueError('%s: only absolute errors are supported' % path)
+    for variable in content['variables']:
+        if variable not in VARIABLES:
+            raise ValueError('%s: unsupported binning variable %s' % (path, variable))
+
+    x_edges = content['binning']['x']
+    y_edges = content['binning']['y']
+
+    # Row-major values, checking that the bins are the ones of the binning
+    values = []
+    if [b['bin'] for b in content['data']] != [[a, b] for a, b in zip(x_edges[:-1], x_edges[1:])]:
+        raise ValueError('%s: the x bins do not match the binning' % path)
+    for x_bin in content['data']:
+        if [b['bin'] for b in x_bin['values']] != [[a, b] for a, b in zip(y_edges[:-1], y_edges[1:])]:
+            raise ValueError('%s: the y bins do not match the binning' % path)
+        for y_bin in x_bin['values']:
+            values.append((y_bin['value'], y_bin['error_low'], y_bin['error_high']))
+
+    name = identifier(path)
+    lines = []
+    lines.append('    // %s' % os.path.relpath(path))
+    lines.append('    constexpr float %s_x[] = {%s};' % (name, ', '.join(float_literal(e) for e in x_edges)))
+    lines.append('    constexpr float %s_y[] = {%s};' % (name, ', '.join(float_literal(e) for e in y_edges)))
+    lines.append('    constexpr EfficiencyValue %s_values[] = {' % name)
+    for i in range(0, len(values), len(y_edges) - 1):
+        row = values[i:i + len(y_edges) - 1]
+        lines.append('        ' + ', '.join('{%s, %s, %s}' % tuple(float_literal(v) for v in value) for value in row) + ',')
+    lines.append('    };')
+    lines.append('    constexpr CompiledBinnedValues %s = {%s, %s, %s_values, nullptr};' % (name,
+        axis(name + '_x', content['variables'][0], x_edges), axis(name + '_y', content['variables'][1], y_edges), name))
+
+    return name, content_hash(path), lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate the compiled efficiency tables')
+    parser.add_argument('-o', '--output', default='interface/EfficiencyTables.h', help='Output header')
+    parser.add_argument('inputs', nargs='*', help='JSON files (default: data/Efficiencies/*.json)')
+    options = parser.parse_args()
+
+    inputs = options.inputs or sorted(glob.glob('data/Efficiencies/*.json'))
+
+    output = []
+    output.append('#pragma once')
+    output.append('')
+    output.append('// Generated by scripts/generateEfficiencyTables.py from the JSON files below, do not edit')
+    output.append('')
+    output.append('#include <cp3_llbb/HHAnalysis/interface/CompiledBinnedValues.h>')
+    output.append('')
+    output.append('namespace HH {')
+    output.append('namespace efficiency_tables {')
+    output.append('')
+
+    names = []
+    for path in inputs:
+        name, hash, lines = generate_table(path)
+        names.append((os.path.join(PACKAGE, os.path.relpath(path)), name, hash))
+        output.extend(lines)
+        output.append('')
+
+    output.append('    // Tables by path of the JSON file, as given to edm::FileInPath, with the hash of the file they were generated from')
+    output.append('    constexpr struct {')
+    output.append('        const char* path;')
+    output.append('        const CompiledBinnedValues* table;')
+    output.append('        uint64_t hash;')
+    output.append('    } all[] = {')
+    for path, name, hash in names:
+        output.append('        {"%s", &%s, 0x%016xull},' % (path, name, hash))
+    output.append('    };')
+    output.append('}')
+    output.append('}')
+
+    with open(options.output, 'w') as f:
+        f.write('\n'.join(output) + '\n')
+
+    print('%d tables written to %s' % (len(names), options.output))
+
+
+if __name__ == '__main__':
+    main()
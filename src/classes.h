@@ -1,4 +1,5 @@
 #include <cp3_llbb/HHAnalysis/interface/Types.h>
+#include <cp3_llbb/HHAnalysis/interface/LegacyTypes.h>
 #include <vector>
 
 namespace {
@@ -9,8 +10,6 @@ namespace {
         std::vector<HH::Dilepton> dummy4;
         HH::Met dummy5;
         std::vector<HH::Met> dummy6;
-        HH::DileptonMet dummy7;
-        std::vector<HH::DileptonMet> dummy8;
         std::vector< std::vector<int> > dummy9;
         HH::Jet dummy10;
         std::vector<HH::Jet> dummy11;
@@ -20,5 +19,9 @@ namespace {
         std::vector<HH::DileptonMetDijet> dummy15;
         std::pair<int8_t, int8_t>  dummy16;
         HH::MELAAngles dummy17;
+        std::vector<std::pair<int8_t, int8_t>> dummy18;
+        HH::legacy::DileptonMet dummy19;
+        HH::legacy::DileptonMetDijet dummy20;
+        std::vector<HH::legacy::DileptonMetDijet> dummy21;
     };
 }
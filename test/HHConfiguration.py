@@ -68,6 +68,19 @@ framework.addAnalyzer('hh_analyzer', cms.PSet(
             hltDRCut = cms.untracked.double(0.1),
             hltDPtCut = cms.untracked.double(0.5),  # cut will be DPt/Pt < hltDPtCut
             applyBJetRegression = cms.untracked.bool(False), # BE SURE TO ACTIVATE computeRegression FLAG BELOW
+            genTruthAfterRecoSelection = cms.untracked.bool(False), # fill the MC truth only for events with a selected dilepton
+            leptonCut = cms.untracked.string(''), # additional cut on the selected leptons, e.g. 'pt > 20 && abs(eta) < 2.1'
+            jetCut = cms.untracked.string(''), # additional cut on the selected jets, e.g. 'CMVAv2 > -0.5884'
+            llmetjjCut = cms.untracked.string(''), # additional cut on the llmetjj candidate, e.g. 'jj_mass < 200 && MT2 > 100'
+            enumerateAllDijets = cms.untracked.bool(False), # only build the best dijet in the jj collection (with llmetjjCut, the dijets tried until one passes)
+            jetPairStrategies = cms.untracked.vstring(), # best jet pair for each of: ht, mh, pt, csv, jp, ptOverM
+            maxJetsForPairing = cms.untracked.uint32(0), # only pair the best N jets (0: no limit)
+            jetPairingRanking = cms.untracked.string('CMVAv2'), # ranking of the jets for maxJetsForPairing: CMVAv2 or pt
+            kinematicsMathMode = cms.untracked.string('exact'), # angular functions: exact, fast (approximations) or validation (exact, differences to fast in the metadata)
+            mt2Precision = cms.untracked.double(0.5), # absolute precision on MT2 (0: machine precision)
+            mt2Threshold = cms.untracked.double(0), # if positive, only compute MT2 until it is known to be above or below this cut, and store 3.4e38 (above) or -2 (below) instead of MT2
+            useCompiledEfficiencyTables = cms.untracked.bool(True), # use interface/EfficiencyTables.h instead of parsing the hlt_efficiencies JSON files
+            mergeWeightedEfficiencies = cms.untracked.bool(True), # merge the parts of the weighted hlt_efficiencies into one table, if they all are in interface/EfficiencyTables.h
 
             hlt_efficiencies = cms.untracked.PSet(
 